@@ -9,9 +9,10 @@ colite::port::threadpool_dispatcher io_dispatcher{1, 5};
 
 colite::suspend<int> data(const char* name) {
     printf("[%s]%s\n", name, __PRETTY_FUNCTION__);
+    colite::interval ticker { 50ms };
     for (auto i : std::views::iota(0) | std::views::take(100)) {
         std::cout << name << "[" << i << "]" << std::this_thread::get_id() << std::endl;
-        co_await 50ms;
+        co_await ticker;
     }
     co_return 123;
 }
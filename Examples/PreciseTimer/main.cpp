@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+
+using namespace std::chrono_literals;
+
+// 定时器唤醒误差的基准：分别在普通模式与高精度模式下，以不同的延迟反复 sleep，统计实际唤醒时间与期望时间之差。
+// 同一调度器上有若干个持续让出的后台协程，模拟繁忙的事件循环
+
+constexpr int rounds = 2000;
+constexpr int background_tasks = 8;
+
+// 后台负载：每次执行约 5us 后让出
+colite::suspend<> busy(const bool& stop) {
+    while (!stop) {
+        auto until = colite::port::current_time() + 5us;
+        while (colite::port::current_time() < until) {
+        }
+        co_await colite::yield();
+    }
+}
+
+colite::suspend<std::vector<double>> measure(colite::dispatcher& dispatcher, colite::port::time_duration delay) {
+    bool stop = false;
+    std::vector<colite::suspend<>> background {};
+    for (int i = 0; i < background_tasks; i++) {
+        background.emplace_back(dispatcher.launch(busy(stop)));
+    }
+    std::vector<double> errors {};
+    errors.reserve(rounds);
+    for (int i = 0; i < rounds; i++) {
+        auto expected = colite::port::current_time() + delay;
+        co_await delay;
+        auto error = colite::port::current_time() - expected;
+        errors.push_back(std::chrono::duration<double, std::micro>(error).count());
+    }
+    stop = true;
+    for (auto& it : background) {
+        co_await std::move(it);
+    }
+    co_return errors;
+}
+
+auto percentile(std::vector<double>& values, double p) -> double {
+    auto index = static_cast<size_t>(p * static_cast<double>(values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+    return values[index];
+}
+
+void run(const char *name, bool precise) {
+    colite::port::eventloop_dispatcher dispatcher;
+    if (precise) {
+        dispatcher.enable_precise_timers();
+    }
+    printf("[%s]\n", name);
+    for (auto delay : { 10us, 50us, 100us, 500us }) {
+        auto errors = dispatcher.run(measure(dispatcher, delay));
+        auto max = *std::max_element(errors.begin(), errors.end());
+        auto p50 = percentile(errors, 0.50);
+        auto p99 = percentile(errors, 0.99);
+        printf("  delay %4lldus: p50 %8.2fus  p99 %8.2fus  max %8.2fus\n", static_cast<long long>(delay.count()), p50, p99, max);
+    }
+    if (precise) {
+        auto stats = dispatcher.get_timer_stats();
+        printf(
+            "  timer lateness: %zu timers, mean %.2fus, max %.2fus\n",
+            stats.count,
+            stats.count ? std::chrono::duration<double, std::micro>(stats.total_lateness).count() / static_cast<double>(stats.count) : 0.0,
+            std::chrono::duration<double, std::micro>(stats.max_lateness).count()
+        );
+    }
+}
+
+int main() {
+    run("normal", false);
+    run("precise", true);
+    return 0;
+}
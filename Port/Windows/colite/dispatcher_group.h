@@ -0,0 +1,138 @@
+#pragma once
+
+#include <windows.h>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "colite/port.h"
+#include "colite/dispatchers.h"
+#include "colite/eventloop_dispatcher.h"
+
+namespace colite::port {
+    // 分片调度器组（thread-per-core）：每个分片是一个运行在独占线程上的事件循环，线程绑定到固定的 CPU。
+    // 协程只在其所属分片上运行，除非显式地 `co_await colite::switch_to(group.shard(n))` 迁移；
+    // 迁移时协程的完成任务随之移到目标分片，等待者的恢复与取消都由协程当前所在的分片处理
+    class dispatcher_group {
+    public:
+        /**
+         * @brief 创建分片调度器组
+         * @param shard_count 分片数量，默认为 CPU 核心数
+         * @param pin_threads 是否将每个分片线程绑定到对应的 CPU
+         */
+        explicit dispatcher_group(
+            size_t shard_count = std::thread::hardware_concurrency(),
+            bool pin_threads = true
+        ) {
+            colite_assert(shard_count > 0);
+            shards_.reserve(shard_count);
+            threads_.reserve(shard_count);
+            for (size_t i = 0; i < shard_count; i++) {
+                shards_.emplace_back(std::make_unique<eventloop_dispatcher>());
+            }
+            for (size_t i = 0; i < shard_count; i++) {
+                threads_.emplace_back([this, i, pin_threads] {
+                    if (pin_threads) {
+                        pin_current_thread(i);
+                    }
+                    shards_[i]->run_forever();
+                });
+            }
+        }
+
+        ~dispatcher_group() {
+            stop();
+        }
+
+        dispatcher_group(const dispatcher_group&) = delete;
+        dispatcher_group& operator=(const dispatcher_group&) = delete;
+
+        /**
+         * @brief 获取分片数量
+         * @return
+         */
+        [[nodiscard]]
+        auto size() const -> size_t { return shards_.size(); }
+
+        /**
+         * @brief 获取指定分片的调度器
+         * @param index 分片序号
+         * @return
+         */
+        [[nodiscard]]
+        auto shard(size_t index) -> eventloop_dispatcher& {
+            colite_assert(index < shards_.size());
+            return *shards_[index];
+        }
+
+        /**
+         * @brief 计算 key 所属的分片
+         * @param key
+         * @return 分片序号
+         */
+        template<typename Key>
+        [[nodiscard]]
+        auto shard_of(const Key& key) const -> size_t {
+            return std::hash<Key>{}(key) % shards_.size();
+        }
+
+        /**
+         * @brief 在指定分片上启动协程
+         * @param index 分片序号
+         * @param coroutine 协程
+         */
+        template<typename Coro>
+            requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
+        auto launch_on(size_t index, Coro&& coroutine) -> decltype(auto) {
+            return shard(index).launch(std::forward<Coro>(coroutine));
+        }
+
+        /**
+         * @brief 按 key 的哈希选择分片并启动协程，相同 key 的协程总是运行在同一个分片上
+         * @param key
+         * @param coroutine 协程
+         */
+        template<typename Key, typename Coro>
+            requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
+        auto launch_by_key(const Key& key, Coro&& coroutine) -> decltype(auto) {
+            return launch_on(shard_of(key), std::forward<Coro>(coroutine));
+        }
+
+        /**
+         * @brief 跨分片传递消息：在目标分片的线程上执行 callable
+         * @param index 分片序号
+         * @param callable
+         */
+        void post(size_t index, colite::callable<void()> callable) {
+            shard(index).post(std::move(callable));
+        }
+
+        /**
+         * @brief 停止所有分片并等待其线程退出
+         */
+        void stop() {
+            for (auto& shard : shards_) {
+                shard->stop();
+            }
+            for (auto& thread : threads_) {
+                if (thread.joinable()) {
+                    thread.join();
+                }
+            }
+        }
+
+    private:
+        std::vector<std::unique_ptr<eventloop_dispatcher>> shards_ {};
+        std::vector<std::thread> threads_ {};
+
+        static void pin_current_thread(size_t index) {
+            constexpr size_t mask_bits = sizeof(DWORD_PTR) * 8;
+            auto cpu_count = static_cast<size_t>(std::thread::hardware_concurrency());
+            if (cpu_count == 0) {
+                return;
+            }
+            auto cpu = index % (std::min)(cpu_count, mask_bits);
+            SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu);
+        }
+    };
+}
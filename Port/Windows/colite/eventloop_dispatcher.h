@@ -1,130 +1,692 @@
 #pragma once
 
-#include <list>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
 #include <mutex>
+#include <ratio>
+#include <stdexcept>
+#include <type_traits>
+#include <windows.h>
 #include "colite/port.h"
+#include "colite/spin_lock.h"
+#include "colite/job_pool.h"
+#include "colite/resume_queue.h"
 #include "colite/dispatchers.h"
+#include "colite/basic_dispatcher.h"
 
 namespace colite::port {
-    class eventloop_dispatcher: public colite::dispatcher {
+    class eventloop_dispatcher final: public colite::basic_dispatcher<eventloop_dispatcher> {
+        friend class colite::basic_dispatcher<eventloop_dispatcher>;
+
     public:
-        class job {
-        public:
-            job(
-                void *id,
-                colite::port::time_duration time,
-                colite::callable<void()> callable
-            ): id(id),
-               ready_time(colite::port::current_time() + time),
-               callable(std::move(callable))
-            {
-            }
+        /**
+         * @brief 创建事件循环
+         * @param max_batch_size 每轮循环最多连续执行的任务数
+         * @param batch_budget 每轮循环的时间预算，超出后剩余的任务留到下一轮，以便检查新到达的任务
+         */
+        explicit eventloop_dispatcher(
+            size_t max_batch_size = 64,
+            colite::port::time_duration batch_budget = std::chrono::milliseconds(1)
+        ): max_batch_size_(max_batch_size),
+           batch_budget_(batch_budget)
+        {
+            colite_assert(max_batch_size > 0);
+        }
 
-            job(
-                void *id,
-                colite::port::time_duration time,
-                colite::callable<void()> callable,
-                colite::callable<bool()> predicate
-            ): id(id),
-               ready_time(colite::port::current_time() + time),
-               callable(std::move(callable)),
-               predicate(std::move(predicate))
-            {
+        ~eventloop_dispatcher() override {
+            if (auto wakeup = wakeup_.load(std::memory_order_acquire)) {
+                CloseHandle(wakeup);
             }
-
-            [[nodiscard]]
-            auto ready() const -> bool {
-                if (predicate) {
-                    return ready_time <= colite::port::current_time() && predicate.value()();
-                } else {
-                    return ready_time <= colite::port::current_time();
+            if (timer_) {
+                CloseHandle(timer_);
+            }
+            for (auto& jobs : jobs_) {
+                while (auto job = jobs.pop_front()) {
+                    colite::detail::job_pool::destroy(*job);
                 }
             }
-
-            void operator()() const {
-                callable();
+            // 恢复节点持有其协程状态，释放仍在队列中的节点
+            for (auto& resumes : resumes_) {
+                while (auto node = resumes.pop_front()) {
+                    release_resume_node(node);
+                }
             }
-
-            [[nodiscard]]
-            auto get_id() const -> void* { return id; }
-
-        private:
-            void *id;
-            colite::port::time_point ready_time;
-            colite::callable<void()> callable;
-            std::optional<colite::callable<bool()>> predicate = std::nullopt;
-        };
-
-        eventloop_dispatcher() = default;
-        ~eventloop_dispatcher() override = default;
+        }
 
         template<typename Coro>
             requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
         auto run(Coro&& coroutine) {
-            bool finished;
             auto&& coro = this->launch(std::forward<Coro>(coroutine));
             while (true) {
                 coro.check_and_throw_exception();
-                {
-                    std::lock_guard locker { lock_ };
-                    finished = jobs_.empty();
-                }
-                if (finished) {
+                auto result = run_batch(colite::port::current_time(), max_batch_size_, batch_budget_);
+                if (!result.has_jobs) {
                     break;
                 }
-                run_once();
+                if (result.executed == 0) {
+                    wait_for_next();
+                }
             }
             return coro.await_resume();
         }
 
+        /**
+         * @brief 持续运行事件循环，直到调用 stop()。用于独占线程的常驻事件循环
+         */
+        void run_forever() {
+            while (!stop_request_) {
+                if (run_batch(colite::port::current_time(), max_batch_size_, batch_budget_).executed > 0) {
+                    continue;
+                }
+                wait_for_next();
+            }
+        }
+
+        // 定时器延迟的统计
+        struct timer_stats {
+            // 统计的延迟任务数
+            size_t count = 0;
+            colite::port::time_duration total_lateness {};
+            colite::port::time_duration max_lateness {};
+            // 延迟的分布：第 0 个桶统计不足 1us 的任务，第 i 个桶统计 [2^(i-1), 2^i) us 的任务，最后一个桶包含更大的延迟
+            std::array<size_t, 16> histogram {};
+        };
+
+        /**
+         * @brief 开启高精度定时器模式，用于 10~500us 的延迟任务：run() 与 run_forever() 没有已就绪的任务时，
+         *        在高精度可等待定时器上休眠到下一个任务的就绪时间之前 spin_window，再自旋到就绪时间，有新任务投递时立即醒来；
+         *        每轮循环在下一个延迟任务就绪时结束，代价是每轮多扫描一次队列、每个任务之后读取时钟。
+         *        同时开始统计延迟任务的实际执行时间与就绪时间之差。须在运行事件循环之前调用
+         * @param spin_window 自旋的时长，应覆盖系统定时器的唤醒误差
+         */
+        void enable_precise_timers(colite::port::time_duration spin_window = std::chrono::microseconds(100)) {
+            if (!timer_) {
+                timer_ = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+            }
+            if (!timer_) {
+                // 较旧的系统不支持高精度定时器，由自旋补偿其误差
+                timer_ = CreateWaitableTimerW(nullptr, FALSE, nullptr);
+            }
+            if (!timer_) {
+                char error_message[56];
+                snprintf(error_message, sizeof(error_message), "CreateWaitableTimer failed. LastError: %lu", GetLastError());
+                colite_throw(std::runtime_error(error_message));
+            }
+            spin_window_ = spin_window;
+            precise_timers_ = true;
+        }
+
+        /**
+         * @brief 获取定时器延迟的统计，只在高精度定时器模式下统计
+         * @return
+         */
+        [[nodiscard]]
+        auto get_timer_stats() -> timer_stats {
+            std::lock_guard locker { lock_ };
+            return timer_stats_;
+        }
+
+        /**
+         * @brief 请求 run_forever() 退出，可在任意线程调用
+         */
+        void stop() {
+            stop_request_ = true;
+            // 唤醒空闲等待中的 run_forever()
+            notify();
+        }
+
+        /**
+         * @brief 执行一轮已就绪的任务后立即返回，不阻塞。用于嵌入宿主程序自己的循环，
+         *        与 run()、run_forever() 一样只应在一个线程上调用
+         * @return 下一个任务的就绪时间，见 next_deadline()
+         */
+        auto poll() -> colite::port::time_point {
+            begin_poll();
+            auto now = colite::port::current_time();
+            run_batch(now, max_batch_size_, batch_budget_);
+            return next_deadline();
+        }
+
+        /**
+         * @brief 至多执行一个已就绪的任务后立即返回，不阻塞
+         * @return 下一个任务的就绪时间，见 next_deadline()
+         */
+        auto poll_one() -> colite::port::time_point {
+            begin_poll();
+            auto now = colite::port::current_time();
+            run_batch(now, 1, batch_budget_);
+            return next_deadline();
+        }
+
+        /**
+         * @brief 在时间预算内反复执行已就绪的任务，预算用完或没有已就绪的任务时返回，不等待延迟任务
+         * @param budget 时间预算
+         * @return 下一个任务的就绪时间，见 next_deadline()
+         */
+        auto run_for(colite::port::time_duration budget) -> colite::port::time_point {
+            begin_poll();
+            auto now = colite::port::current_time();
+            auto deadline = now + budget;
+            while (now < deadline) {
+                if (run_batch(now, max_batch_size_, std::min(batch_budget_, deadline - now)).executed == 0) {
+                    break;
+                }
+                now = colite::port::current_time();
+            }
+            return next_deadline();
+        }
+
+        /**
+         * @brief 获取下一个任务的就绪时间，宿主循环可以据此决定等待唤醒句柄的超时时间。
+         *        不扫描队列：最早的就绪时间在入队时更新，只有最早的延迟任务出队之后才重新计算一次
+         * @return 不晚于当前时间表示可能已有就绪的任务，time_point::max() 表示没有可以按时间等待的任务
+         *         （例如只剩等待子协程结束的任务，子协程结束时会置位唤醒句柄）
+         */
+        [[nodiscard]]
+        auto next_deadline() -> colite::port::time_point {
+            std::lock_guard locker { lock_ };
+            if (maybe_ready_) {
+                return colite::port::time_point::min();
+            }
+            if (earliest_stale_) {
+                earliest_ = earliest_deadline(colite::port::current_time());
+                earliest_stale_ = false;
+            }
+            return earliest_;
+        }
+
+        /**
+         * @brief 获取唤醒句柄（手动重置的事件）。有新任务投递到该调度器时句柄被置位，
+         *        poll()、poll_one()、run_for() 开始时将其复位，宿主循环可以等待该句柄直到 next_deadline()：
+         *        ```
+         *        auto wakeup = loop.get_wakeup_handle();
+         *        while (running) {
+         *            auto next = loop.poll();
+         *            WaitForMultipleObjects(..., wakeup, ..., timeout_until(next));
+         *        }
+         *        ```
+         *        第一次调用时创建，创建时即为置位状态
+         * @return 事件句柄，由调度器关闭
+         */
+        auto get_wakeup_handle() -> HANDLE {
+            auto wakeup = wakeup_.load(std::memory_order_acquire);
+            if (wakeup) {
+                return wakeup;
+            }
+            auto created = CreateEventW(nullptr, TRUE, TRUE, nullptr);
+            if (!created) {
+                char error_message[48];
+                snprintf(error_message, sizeof(error_message), "CreateEvent failed. LastError: %lu", GetLastError());
+                colite_throw(std::runtime_error(error_message));
+            }
+            signaled_.store(true, std::memory_order_release);
+            if (!wakeup_.compare_exchange_strong(wakeup, created, std::memory_order_acq_rel)) {
+                CloseHandle(created);
+            }
+            return wakeup_.load(std::memory_order_acquire);
+        }
+
     private:
-        std::recursive_mutex lock_ {};
-        std::list<job, colite::allocator::allocator<job>> jobs_ {};
+        using job_list = colite::detail::job_list;
+        using job_pool = colite::detail::job_pool;
+
+        // 每执行多少个任务检查一次时间预算
+        static constexpr size_t budget_check_interval = 16;
+
+        // 较低优先级连续多少轮没有得到执行后，在下一轮优先执行
+        static constexpr size_t starvation_rounds = 8;
+
+        const size_t max_batch_size_;
+        const colite::port::time_duration batch_budget_;
+        std::atomic<bool> stop_request_ = false;
+        // 唤醒句柄，及其是否已被置位
+        std::atomic<HANDLE> wakeup_ = nullptr;
+        std::atomic<bool> signaled_ = false;
+        // 高精度定时器模式
+        bool precise_timers_ = false;
+        colite::port::time_duration spin_window_ {};
+        HANDLE timer_ = nullptr;
+        // 可能有已就绪的任务：投递立即任务或条件任务、协程结束时置位，一轮取完所有就绪的任务时清除，由 lock_ 保护
+        bool maybe_ready_ = false;
+        // 队列中延迟任务最早的就绪时间，及其是否已随最早的任务出队而过时，由 lock_ 保护
+        colite::port::time_point earliest_ = colite::port::time_point::max();
+        bool earliest_stale_ = false;
+        // 本轮开始之后投递的最早的延迟任务的就绪时间，由 lock_ 保护写入
+        std::atomic<colite::port::time_point> new_timer_ = colite::port::time_point::max();
+        // 定时器延迟的统计，由 lock_ 保护
+        timer_stats timer_stats_ {};
+        colite::port::spin_lock lock_ {};
+        // 任务记录的存储，由 lock_ 保护
+        job_pool pool_ {};
+        // 每个优先级一个队列
+        std::array<job_list, colite::priority_count> jobs_ {};
+        // 恢复协程的任务，节点内嵌在协程状态中
+        std::array<colite::detail::resume_queue, colite::priority_count> resumes_ {};
+        std::array<size_t, colite::priority_count> starved_rounds_ {};
+
+        // 有新任务时置位唤醒句柄，已置位时不重复调用 SetEvent
+        void notify() {
+            auto wakeup = wakeup_.load(std::memory_order_acquire);
+            if (wakeup && !signaled_.exchange(true, std::memory_order_acq_rel)) {
+                SetEvent(wakeup);
+            }
+        }
+
+        // 复位唤醒句柄，之后投递的任务会再次置位。先复位事件再清除标记，避免丢失唤醒
+        void begin_poll() {
+            if (auto wakeup = wakeup_.load(std::memory_order_acquire)) {
+                ResetEvent(wakeup);
+                signaled_.store(false, std::memory_order_release);
+            }
+        }
+
+        /**
+         * @brief 没有已就绪的任务时等待，直到下一个任务就绪或有新任务投递，不占用 CPU。
+         *        高精度模式下在高精度定时器上休眠到就绪时间之前 spin_window_，再自旋到就绪时间；
+         *        否则在唤醒句柄上等待，系统等待的精度为毫秒
+         */
+        void wait_for_next() {
+            auto wakeup = get_wakeup_handle();
+            // 先复位唤醒句柄再读取就绪时间，之后投递的任务会使等待立即返回
+            begin_poll();
+            auto next = next_deadline();
+            if (next == colite::port::time_point::max()) {
+                // 没有延迟任务：等待子协程结束的任务在子协程结束时经由 coroutine_finished 置位唤醒句柄，不必定期检查
+                WaitForSingleObject(wakeup, INFINITE);
+                return;
+            }
+            auto now = colite::port::current_time();
+            if (next <= now) {
+                return;
+            }
+            if (!precise_timers_) {
+                // 向上取整，不早于就绪时间醒来
+                auto ms = std::chrono::ceil<std::chrono::milliseconds>(next - now).count();
+                WaitForSingleObject(wakeup, static_cast<DWORD>(std::min<long long>(ms, INFINITE - 1)));
+                return;
+            }
+            if (next - now > spin_window_) {
+                LARGE_INTEGER due {};
+                // 负数表示相对时间，单位为 100ns
+                due.QuadPart = -std::chrono::duration_cast<std::chrono::duration<long long, std::ratio<1, 10000000>>>(next - now - spin_window_).count();
+                SetWaitableTimer(timer_, &due, 0, nullptr, nullptr, FALSE);
+                HANDLE handles[] = { wakeup, timer_ };
+                if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) == WAIT_OBJECT_0) {
+                    CancelWaitableTimer(timer_);
+                    return;
+                }
+            }
+            while (colite::port::current_time() < next) {
+                colite_cpu_relax();
+            }
+        }
+
+        // 记录新投递的任务：立即任务与条件任务可能已就绪，延迟任务更新最早的就绪时间，须持有锁
+        void note_job(colite::port::time_point ready_time, bool has_predicate) {
+            if (ready_time == colite::port::time_point::min() || has_predicate) {
+                maybe_ready_ = true;
+            }
+            if (ready_time != colite::port::time_point::min()) {
+                earliest_ = std::min(earliest_, ready_time);
+            }
+            note_timer(ready_time);
+        }
+
+        // 任务出队或被删除，若其中有最早的延迟任务，最早的就绪时间在下次需要时重新计算，须持有锁
+        template<typename List>
+        void note_removed(const List& removed) {
+            for (auto entry = removed.front(); entry && !earliest_stale_; entry = entry->next_) {
+                earliest_stale_ = entry->ready_time_ == earliest_;
+            }
+        }
+
+        // 高精度模式下记录新投递的延迟任务，正在执行的一轮在其就绪时结束，须持有锁
+        void note_timer(colite::port::time_point ready_time) {
+            if (precise_timers_ && ready_time != colite::port::time_point::min() && ready_time < new_timer_.load(std::memory_order_relaxed)) {
+                new_timer_.store(ready_time, std::memory_order_relaxed);
+            }
+        }
+
+        void coroutine_finished() noexcept override {
+            {
+                std::lock_guard locker { lock_ };
+                maybe_ready_ = true;
+            }
+            notify();
+        }
+
+        // 记录延迟任务的实际执行时间与就绪时间之差
+        static void record_lateness(timer_stats& stats, colite::port::time_point ready_time) {
+            auto lateness = std::max(colite::port::current_time() - ready_time, colite::port::time_duration::zero());
+            stats.count++;
+            stats.total_lateness += lateness;
+            stats.max_lateness = std::max(stats.max_lateness, lateness);
+            auto us = std::chrono::duration_cast<std::chrono::microseconds>(lateness).count();
+            size_t bucket = 0;
+            while (us > 0 && bucket + 1 < stats.histogram.size()) {
+                us >>= 1;
+                bucket++;
+            }
+            stats.histogram[bucket]++;
+        }
+
+        void dispatch_resume(
+            const std::shared_ptr<base_coroutine_state>& state,
+            colite::port::time_duration time
+        ) override {
+            auto node = acquire_resume_node(state, time);
+            if (!node) {
+                colite::dispatcher::dispatch_resume(state, time);
+                return;
+            }
+            {
+                std::lock_guard locker { lock_ };
+                resumes_[static_cast<size_t>(state->get_priority())].push_back(node);
+                note_job(node->ready_time_, false);
+            }
+            notify();
+        }
 
         void dispatch(
             void *id,
             colite::port::time_duration time,
+            colite::priority priority,
             colite::callable<void()> callable
         ) override {
-            std::lock_guard locker { lock_ };
-            jobs_.emplace_back(id, time, std::move(callable));
+            auto ready_time = job_pool::make_ready_time(time);
+            {
+                std::lock_guard locker { lock_ };
+                jobs_[static_cast<size_t>(priority)].push_back(pool_.acquire(id, ready_time, std::move(callable), colite::callable<bool()> {}));
+                note_job(ready_time, false);
+            }
+            notify();
         }
 
         void dispatch(
             void *id,
             colite::port::time_duration time,
+            colite::priority priority,
             colite::callable<void()> callable,
             colite::callable<bool()> predicate
         ) override {
-            std::lock_guard locker { lock_ };
-            jobs_.emplace_back(id, time, std::move(callable), std::move(predicate));
+            auto ready_time = job_pool::make_ready_time(time);
+            {
+                std::lock_guard locker { lock_ };
+                jobs_[static_cast<size_t>(priority)].push_back(pool_.acquire(id, ready_time, std::move(callable), std::move(predicate)));
+                note_job(ready_time, true);
+            }
+            notify();
+        }
+
+        void dispatch_revocable(
+            void *id,
+            colite::port::time_duration time,
+            colite::priority priority,
+            colite::callable<void()> callable,
+            const std::atomic<bool> *tombstone
+        ) override {
+            auto ready_time = job_pool::make_ready_time(time);
+            {
+                std::lock_guard locker { lock_ };
+                jobs_[static_cast<size_t>(priority)].push_back(pool_.acquire(id, ready_time, std::move(callable), colite::callable<bool()> {}, tombstone));
+                note_job(ready_time, false);
+            }
+            notify();
         }
 
         void cancel_jobs(void *id) override {
-            std::lock_guard locker { lock_ };
-            jobs_.remove_if([=] (const job& it) {
-                 return id == it.get_id();
-            });
+            // 被删除的任务在锁外析构，避免其捕获的对象在析构时重入调度器
+            job_list removed {};
+            colite::detail::resume_queue removed_resumes {};
+            {
+                std::lock_guard locker { lock_ };
+                for (auto& jobs : jobs_) {
+                    jobs.take_if(removed, SIZE_MAX, [id] (const colite::detail::job_header& job) { return job.id_ == id; });
+                }
+                for (auto& resumes : resumes_) {
+                    resumes.take_if(removed_resumes, SIZE_MAX, [id] (const colite::detail::resume_node& node) { return node.id_ == id; });
+                }
+                note_removed(removed);
+                note_removed(removed_resumes);
+            }
+            if (!removed.empty()) {
+                for (auto job = removed.front(); job; job = job->next_) {
+                    job_pool::destroy(*job);
+                }
+                std::lock_guard locker { lock_ };
+                pool_.recycle(removed);
+            }
+            while (auto node = removed_resumes.pop_front()) {
+                release_resume_node(node);
+            }
+        }
+
+        // 是否还有待执行的任务，须持有锁
+        [[nodiscard]]
+        auto has_jobs() const -> bool {
+            for (size_t i = 0; i < colite::priority_count; i++) {
+                if (!jobs_[i].empty() || !resumes_[i].empty()) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 重新计算队列中延迟任务最早的就绪时间，须持有锁。
+         *        已过就绪时间而条件尚未成立的条件任务不计入，它们在条件成立时经由 maybe_ready_ 触发
+         */
+        [[nodiscard]]
+        auto earliest_deadline(colite::port::time_point now) const -> colite::port::time_point {
+            auto earliest = colite::port::time_point::max();
+            for (size_t i = 0; i < colite::priority_count; i++) {
+                for (auto job = jobs_[i].front(); job; job = job->next_) {
+                    if (job->ready_time_ != colite::port::time_point::min() && (!job->has_predicate_ || job->ready_time_ > now)) {
+                        earliest = std::min(earliest, job->ready_time_);
+                    }
+                }
+                for (auto node = resumes_[i].front(); node; node = node->next_) {
+                    if (node->ready_time_ != colite::port::time_point::min()) {
+                        earliest = std::min(earliest, node->ready_time_);
+                    }
+                }
+            }
+            return earliest;
+        }
+
+        // 尚未就绪的延迟任务中最早的就绪时间，须持有锁
+        [[nodiscard]]
+        auto earliest_timer(colite::port::time_point now) const -> colite::port::time_point {
+            auto earliest = colite::port::time_point::max();
+            for (size_t i = 0; i < colite::priority_count; i++) {
+                for (auto job = jobs_[i].front(); job; job = job->next_) {
+                    if (job->ready_time_ > now) {
+                        earliest = std::min(earliest, job->ready_time_);
+                    }
+                }
+                for (auto node = resumes_[i].front(); node; node = node->next_) {
+                    if (node->ready_time_ > now) {
+                        earliest = std::min(earliest, node->ready_time_);
+                    }
+                }
+            }
+            return earliest;
+        }
+
+        /**
+         * @brief 按顺序从 from 中取出至多 limit 个就绪的任务，追加到 to 的末尾
+         * @return 取出的任务数
+         */
+        template<typename List>
+        static auto take_ready(List& from, List& to, size_t limit, colite::port::time_point now) -> size_t {
+            if constexpr (std::is_same_v<List, job_list>) {
+                return from.take_if(to, limit, [now] (const colite::detail::job_header& job) { return job_pool::ready(job, now); });
+            } else {
+                return from.take_if(to, limit, [now] (const colite::detail::resume_node& node) { return node.ready_time_ <= now; });
+            }
         }
 
-        void run_once() {
-            std::optional<job> job = std::nullopt;
+        /**
+         * @brief 按顺序从 from 中取出至多 limit 个已到期的延迟任务，追加到 to 的末尾
+         * @return 取出的任务数
+         */
+        template<typename List>
+        static auto take_expired(List& from, List& to, size_t limit, colite::port::time_point now) -> size_t {
+            if constexpr (std::is_same_v<List, job_list>) {
+                return from.take_if(to, limit, [now] (const colite::detail::job_header& job) {
+                    return job.ready_time_ != colite::port::time_point::min() && job_pool::ready(job, now);
+                });
+            } else {
+                return from.take_if(to, limit, [now] (const colite::detail::resume_node& node) {
+                    return node.ready_time_ != colite::port::time_point::min() && node.ready_time_ <= now;
+                });
+            }
+        }
+
+        struct batch_result {
+            // 本轮执行的任务数
+            size_t executed;
+            // 本轮结束后是否还有待执行的任务
+            bool has_jobs;
+        };
+
+        /**
+         * @brief 执行一轮循环：在一次加锁中按优先级从高到低取出一批就绪的任务，在锁外依次执行
+         * @param now 本轮循环读取的当前时间，同一轮中的就绪判断共用该时间
+         * @param max_batch 本轮最多执行的任务数
+         * @param budget 本轮的时间预算
+         */
+        auto run_batch(colite::port::time_point now, size_t max_batch, colite::port::time_duration budget) -> batch_result {
+            std::array<job_list, colite::priority_count> batches {};
+            std::array<colite::detail::resume_queue, colite::priority_count> resume_batches {};
+            // 高精度模式下，本轮在下一个延迟任务就绪时结束，以免其等待整批任务执行完
+            auto next_timer = colite::port::time_point::max();
+            // 从一个优先级中取出至多 limit 个就绪的任务，恢复任务与普通任务各占一半的份额，一方不足时由另一方补足
+            auto take = [&] (size_t i, size_t limit) -> size_t {
+                size_t taken = 0;
+                if (precise_timers_) {
+                    // 高精度模式下已到期的延迟任务排在本轮的最前面
+                    taken += take_expired(resumes_[i], resume_batches[i], limit, now);
+                    taken += take_expired(jobs_[i], batches[i], limit - taken, now);
+                }
+                taken += take_ready(jobs_[i], batches[i], (limit - taken + 1) / 2, now);
+                taken += take_ready(resumes_[i], resume_batches[i], limit - taken, now);
+                taken += take_ready(jobs_[i], batches[i], limit - taken, now);
+                return taken;
+            };
             {
                 std::lock_guard locker { lock_ };
-                if (jobs_.empty()) {
-                    return;
+                size_t taken = 0;
+                // 饥饿的较低优先级先取
+                for (size_t i = 1; i < colite::priority_count; i++) {
+                    if (starved_rounds_[i] >= starvation_rounds) {
+                        taken += take(i, max_batch - taken);
+                    }
+                }
+                for (size_t i = 0; i < colite::priority_count && taken < max_batch; i++) {
+                    taken += take(i, max_batch - taken);
+                }
+                for (size_t i = 1; i < colite::priority_count; i++) {
+                    if (!batches[i].empty() || !resume_batches[i].empty() || (jobs_[i].empty() && resumes_[i].empty())) {
+                        starved_rounds_[i] = 0;
+                    } else {
+                        starved_rounds_[i]++;
+                    }
+                }
+                // 没有取满时每个队列都已完整扫描过，剩下的任务都尚未就绪
+                if (taken < max_batch) {
+                    maybe_ready_ = false;
                 }
-                if (jobs_.front().ready()) {
-                    job = std::move(jobs_.front());
-                    jobs_.pop_front();
-                } else {
-                    jobs_.splice(jobs_.cend(), jobs_, jobs_.cbegin());
+                // 最早的延迟任务已出队，或已到期但条件尚未成立
+                if (earliest_ <= now) {
+                    earliest_stale_ = true;
+                }
+                for (size_t i = 0; i < colite::priority_count; i++) {
+                    note_removed(batches[i]);
+                    note_removed(resume_batches[i]);
+                }
+                if (taken == 0) {
+                    return batch_result { .executed = 0, .has_jobs = has_jobs() };
+                }
+                if (precise_timers_) {
+                    next_timer = earliest_timer(now);
+                    new_timer_.store(colite::port::time_point::max(), std::memory_order_relaxed);
                 }
             }
 
-            if (job) {
-                job.value()();
+            // 已执行的任务记录，在最后一次加锁时回收
+            job_list finished {};
+            // 本轮的定时器延迟，在最后一次加锁时合并
+            timer_stats lateness {};
+            auto deadline = std::min(now + budget, next_timer);
+            // 高精度模式下每个任务之后都检查时间
+            auto check_interval = precise_timers_ ? 1 : budget_check_interval;
+            size_t executed = 0;
+            bool over_budget = false;
+            auto count = [&] {
+                executed++;
+                if (executed % check_interval == 0 && colite::port::current_time() >= std::min(deadline, new_timer_.load(std::memory_order_relaxed))) {
+                    over_budget = true;
+                }
+            };
+            // 超出时间预算而未执行的任务放回各自队列的队首，保持原有顺序
+            auto restore = [&] {
+                std::lock_guard locker { lock_ };
+                pool_.recycle(finished);
+                if (lateness.count > 0) {
+                    timer_stats_.count += lateness.count;
+                    timer_stats_.total_lateness += lateness.total_lateness;
+                    timer_stats_.max_lateness = std::max(timer_stats_.max_lateness, lateness.max_lateness);
+                    for (size_t i = 0; i < lateness.histogram.size(); i++) {
+                        timer_stats_.histogram[i] += lateness.histogram[i];
+                    }
+                }
+                for (size_t i = 0; i < colite::priority_count; i++) {
+                    // 放回的任务都已就绪
+                    maybe_ready_ = maybe_ready_ || !batches[i].empty() || !resume_batches[i].empty();
+                    jobs_[i].splice_front(batches[i]);
+                    resumes_[i].splice_front(resume_batches[i]);
+                }
+                return batch_result { .executed = executed, .has_jobs = has_jobs() };
+            };
+            job_scope scope { *this };
+            for (size_t i = 0; i < colite::priority_count; i++) {
+                while (!resume_batches[i].empty() && !over_budget) {
+                    auto node = resume_batches[i].pop_front();
+                    if (precise_timers_ && node->ready_time_ != colite::port::time_point::min()) {
+                        record_lateness(lateness, node->ready_time_);
+                    }
+                    run_resume_node(node);
+                    count();
+                }
+                auto& batch = batches[i];
+                while (!batch.empty() && !over_budget) {
+                    auto job = batch.pop_front();
+                    finished.push_back(job);
+                    // 提前出队的已作废任务不计入延迟统计
+                    if (precise_timers_ && job->ready_time_ != colite::port::time_point::min() && job->ready_time_ <= now) {
+                        record_lateness(lateness, job->ready_time_);
+                    }
+#ifdef COLITE_NO_EXCEPTIONS
+                    job_pool::run(*job);
+#else
+                    try {
+                        job_pool::run(*job);
+                    } catch (...) {
+                        // 任务抛出的异常交给调用者，其余任务保留在队列中
+                        job_pool::destroy(*job);
+                        restore();
+                        throw;
+                    }
+#endif
+                    job_pool::destroy(*job);
+                    count();
+                }
             }
+            return restore();
         }
     };
-}
\ No newline at end of file
+}
@@ -1,12 +1,35 @@
 #pragma once
 
+#include <atomic>
 #include <cassert>
 #include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
 #include <unordered_map>
 #include <mutex>
 
+#if defined(_M_IX86) || defined(_M_X64)
+#include <intrin.h>
+#elif defined(__i386__) || defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
 #define colite_assert(...) assert(__VA_ARGS__)
 
+// 编译器关闭了异常（-fno-exceptions、/EHs-c-）时同样视为 COLITE_NO_EXCEPTIONS
+#if !defined(COLITE_NO_EXCEPTIONS) && !defined(__cpp_exceptions) && !defined(_CPPUNWIND)
+#define COLITE_NO_EXCEPTIONS
+#endif
+
+// 抛出异常；COLITE_NO_EXCEPTIONS 下输出异常的说明后终止程序
+#ifdef COLITE_NO_EXCEPTIONS
+#define colite_throw(...) ::colite::port::fatal_error(__VA_ARGS__)
+#else
+#define colite_throw(...) throw __VA_ARGS__
+#endif
+
 inline class Leak {
 public:
     Leak() = default;
@@ -38,8 +61,85 @@ namespace colite {
         using time_duration = std::chrono::steady_clock::duration;
         using time_point = std::chrono::steady_clock::time_point;
 
+        /**
+         * @brief 没有异常时代替 throw：输出异常的说明并终止程序，用于无法以返回值报告的错误
+         * @param exception 本应抛出的异常
+         */
+        template<typename Exception>
+        [[noreturn]] void fatal_error(const Exception& exception) {
+            fprintf(stderr, "colite: %s\n", exception.what());
+            std::abort();
+        }
+
+        namespace detail {
+            // TSC 与 steady_clock 之间的换算关系
+            struct tsc_calibration {
+                uint64_t tsc = 0;
+                time_point time {};
+                double ns_per_tick = 0.0;
+            };
+
+            // 由 calibrate_tsc_clock() 写入，之后只读
+            inline tsc_calibration tsc_clock_calibration {};
+        }
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+        inline auto read_tsc() -> uint64_t {
+            return __rdtsc();
+        }
+
+        /**
+         * @brief 校准 TSC 时钟：在 window 内对照 steady_clock 测量 TSC 的频率，调用线程休眠 window。
+         *        定义 COLITE_TSC_CLOCK 时须在启动任何调度器、读取 current_time() 之前调用一次；
+         *        之后 tsc_time() 只做乘加，不再检查是否已校准
+         * @param window 测量的时长，越长越精确
+         */
+        inline void calibrate_tsc_clock(std::chrono::milliseconds window = std::chrono::milliseconds(10)) {
+            auto begin_time = std::chrono::steady_clock::now();
+            auto begin_tsc = read_tsc();
+            std::this_thread::sleep_for(window);
+            auto end_time = std::chrono::steady_clock::now();
+            auto end_tsc = read_tsc();
+            auto ns = std::chrono::duration<double, std::nano>(end_time - begin_time).count();
+            detail::tsc_clock_calibration = detail::tsc_calibration {
+                .tsc = end_tsc,
+                .time = end_time,
+                .ns_per_tick = ns / static_cast<double>(end_tsc - begin_tsc)
+            };
+        }
+
+        /**
+         * @brief 读取 TSC 并按 calibrate_tsc_clock() 的结果换算为时间点，误差在微秒级，适用于可以容忍该误差的定时器
+         * @return
+         */
+        inline auto tsc_time() -> time_point {
+            auto& calibration = detail::tsc_clock_calibration;
+            colite_assert(calibration.ns_per_tick > 0.0);
+            auto ticks = static_cast<int64_t>(read_tsc() - calibration.tsc);
+            return calibration.time + std::chrono::duration_cast<time_duration>(
+                std::chrono::duration<double, std::nano>(static_cast<double>(ticks) * calibration.ns_per_tick)
+            );
+        }
+#else
+        // 当前平台没有 TSC，tsc_time() 即 steady_clock，无需校准
+        inline void calibrate_tsc_clock(std::chrono::milliseconds = std::chrono::milliseconds(10)) {  }
+
+        inline auto tsc_time() -> time_point {
+            return std::chrono::steady_clock::now();
+        }
+#endif
+
+        /**
+         * @brief 调度器读取的时钟，在编译期选定：默认为 steady_clock，定义 COLITE_TSC_CLOCK 时为 tsc_time()，
+         *        此时须先调用 calibrate_tsc_clock()。仿真调度器不经过这里，而是使用自己的虚拟时钟（见 dispatcher::clock）
+         * @return
+         */
         inline auto current_time() -> time_point {
+#ifdef COLITE_TSC_CLOCK
+            return tsc_time();
+#else
             return std::chrono::steady_clock::now();
+#endif
         }
 
         inline void* calloc(size_t n,size_t size) {
@@ -1,25 +1,71 @@
 #pragma once
 
 #include <atomic>
+#include <cstdint>
+#include <thread>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#include <immintrin.h>
+#define colite_cpu_relax() _mm_pause()
+#else
+#define colite_cpu_relax() std::this_thread::yield()
+#endif
 
 namespace colite::port {
-    class spin_lock {
+    // 自适应锁：先 test-and-test-and-set 自旋（pause + 指数退避），超过自旋上限后在原子变量上休眠
+    // （std::atomic::wait，Windows 上即 WaitOnAddress），避免持锁线程被抢占时白白耗尽时间片。
+    // 满足 Lockable 要求，可直接替代 std::mutex 用于 std::lock_guard / std::unique_lock
+    class alignas(64) spin_lock {
     public:
+        // 自旋阶段的最大退避次数（每轮 pause 次数依次为 1, 2, 4 ... max_backoff）
+        static constexpr uint32_t max_backoff = 64;
+
         spin_lock() = default;
 
         spin_lock(const spin_lock&) = delete;
         spin_lock& operator=(const spin_lock&) = delete;
 
         void lock() {
-            while (locked_.test_and_set(std::memory_order_acquire)) {
-                ;
+            if (try_lock()) {
+                return;
             }
+            lock_slow();
+        }
+
+        [[nodiscard]]
+        auto try_lock() -> bool {
+            uint32_t expected = UNLOCKED;
+            return state_.load(std::memory_order_relaxed) == UNLOCKED
+                && state_.compare_exchange_strong(expected, LOCKED, std::memory_order_acquire, std::memory_order_relaxed);
         }
 
         void unlock() {
-            locked_.clear(std::memory_order_release);
+            if (state_.exchange(UNLOCKED, std::memory_order_release) == CONTENDED) {
+                state_.notify_one();
+            }
         }
+
     private:
-        std::atomic_flag locked_ = ATOMIC_FLAG_INIT;
+        // 未上锁 / 已上锁且无休眠者 / 已上锁且可能有休眠者
+        static constexpr uint32_t UNLOCKED = 0;
+        static constexpr uint32_t LOCKED = 1;
+        static constexpr uint32_t CONTENDED = 2;
+
+        std::atomic<uint32_t> state_ = UNLOCKED;
+
+        void lock_slow() {
+            for (uint32_t backoff = 1; backoff <= max_backoff; backoff <<= 1) {
+                for (uint32_t i = 0; i < backoff; i++) {
+                    colite_cpu_relax();
+                }
+                if (try_lock()) {
+                    return;
+                }
+            }
+            // 标记为 CONTENDED 后休眠，解锁者据此决定是否需要唤醒
+            while (state_.exchange(CONTENDED, std::memory_order_acquire) != UNLOCKED) {
+                state_.wait(CONTENDED, std::memory_order_relaxed);
+            }
+        }
     };
 }
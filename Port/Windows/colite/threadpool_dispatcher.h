@@ -1,148 +1,102 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <optional>
+#include <vector>
 #include <windows.h>
 #include "threadpoolapiset.h"
 #include "colite/port.h"
+#include "colite/allocator.h"
+#include "colite/spin_lock.h"
+#include "colite/job_pool.h"
+#include "colite/resume_queue.h"
 #include "colite/dispatchers.h"
+#include "colite/basic_dispatcher.h"
 
 namespace colite::port {
-    class threadpool_dispatcher: public colite::dispatcher {
-    public:
-        class job {
-        public:
-            job(
-                void *id,
-                colite::port::time_duration time,
-                colite::callable<void()> callable
-            ): id(id),
-               ready_time(colite::port::current_time() + time),
-               callable(std::move(callable))
-            {
-            }
-
-            job(
-                void *id,
-                colite::port::time_duration time,
-                colite::callable<void()> callable,
-                colite::callable<bool()> predicate
-            ): id(id),
-               ready_time(colite::port::current_time() + time),
-               callable(std::move(callable)),
-               predicate(std::move(predicate))
-            {
-            }
-
-            [[nodiscard]]
-            auto ready() const -> bool {
-                if (predicate) {
-                    return ready_time <= colite::port::current_time() && predicate.value()();
-                } else {
-                    return ready_time <= colite::port::current_time();
-                }
-            }
-
-            [[nodiscard]]
-            auto get_id() const -> void* { return id; }
-
-            [[nodiscard]]
-            auto get_callable() const& -> colite::callable<void()> { return callable; }
-            auto get_callable() & -> colite::callable<void()> { return callable; }
-            auto get_callable() && -> colite::callable<void()> { return std::move(callable); }
-
-        private:
-            void *id;
-            colite::port::time_point ready_time;
-            colite::callable<void()> callable;
-            std::optional<colite::callable<bool()>> predicate = std::nullopt;
-        };
-
-        struct job_task_args;
-
-        class threadpool_job {
-        public:
-            enum class Type { None, Work, Timer };
-            explicit threadpool_job(void* id, job_task_args* args, PTP_WORK work):
-                id_(id), args_(args), type_(Type::Work), handle_{.work_ = work} { }
-            explicit threadpool_job(void* id, job_task_args* args, PTP_TIMER timer):
-                id_(id), args_(args), type_(Type::Timer), handle_{.timer_ = timer} { }
-
-            [[nodiscard]]
-            auto get_id() const -> void* { return id_; }
-
-            [[nodiscard]]
-            auto get_args() -> job_task_args* { return args_; }
-
-            [[nodiscard]]
-            auto get_args() const -> job_task_args* { return args_; }
-
-            ~threadpool_job() {
-                switch (type_) {
-                    case Type::Work: {
-                        CloseThreadpoolWork(handle_.work_);
-                        break;
-                    }
-                    case Type::Timer: {
-                        CloseThreadpoolTimer(handle_.timer_);
-                        break;
-                    }
-                    default:
-                        break;
-                }
-            }
-        private:
-            void* const id_ = nullptr;
-            job_task_args* const args_ = nullptr;
-            const Type type_ = Type::None;
-            const union {
-                PTP_WORK work_ = nullptr;
-                PTP_TIMER timer_;
-            } handle_;
-        };
-
-        struct job_task_args {
-            threadpool_dispatcher& dispatcher_;
-            threadpool_job job_;
-            colite::callable<void()> callable_;
-        };
+    class threadpool_dispatcher final: public colite::basic_dispatcher<threadpool_dispatcher> {
+        friend class colite::basic_dispatcher<threadpool_dispatcher>;
 
+    public:
         explicit threadpool_dispatcher(DWORD minimum_thread_count = 5, DWORD maximun_thread_count = 10)
         {
             // colite_assert(maximun_thread_count >= minimum_thread_count, "The maximum number of threads must be greater than the minimum");
             colite_assert(maximun_thread_count >= minimum_thread_count);
-            InitializeThreadpoolEnvironment(&callback_environ_);
 
             thread_pool_ = CreateThreadpool(nullptr);
             if (!thread_pool_) {
                 char error_message[48];
                 snprintf(error_message, sizeof(error_message), "CreateThreadpool failed. LastError: %lu", GetLastError());
                 cleanup();
-                throw std::runtime_error(error_message);
+                colite_throw(std::runtime_error(error_message));
             }
             SetThreadpoolThreadMaximum(thread_pool_, maximun_thread_count);
             SetThreadpoolThreadMinimum(thread_pool_, minimum_thread_count);
-            SetThreadpoolCallbackPool(&callback_environ_, thread_pool_);
+
+            operator_wakeup_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+            if (!operator_wakeup_) {
+                char error_message[48];
+                snprintf(error_message, sizeof(error_message), "CreateEvent failed. LastError: %lu", GetLastError());
+                cleanup();
+                colite_throw(std::runtime_error(error_message));
+            }
 
             cleanup_group_ = CreateThreadpoolCleanupGroup();
             if (!cleanup_group_) {
                 char error_message[48];
                 snprintf(error_message, sizeof(error_message), "CreateThreadpoolCleanupGroup failed. LastError: %lu", GetLastError());
                 cleanup();
-                throw std::runtime_error(error_message);
+                colite_throw(std::runtime_error(error_message));
+            }
+
+            // 每个优先级一个回调环境，由线程池按回调优先级调度已提交的任务
+            constexpr TP_CALLBACK_PRIORITY callback_priorities[colite::priority_count] = {
+                TP_CALLBACK_PRIORITY_HIGH,
+                TP_CALLBACK_PRIORITY_NORMAL,
+                TP_CALLBACK_PRIORITY_LOW
+            };
+            for (size_t i = 0; i < colite::priority_count; i++) {
+                InitializeThreadpoolEnvironment(&callback_environs_[i]);
+                SetThreadpoolCallbackPool(&callback_environs_[i], thread_pool_);
+                SetThreadpoolCallbackCleanupGroup(&callback_environs_[i], cleanup_group_, nullptr);
+                SetThreadpoolCallbackPriority(&callback_environs_[i], callback_priorities[i]);
             }
-            SetThreadpoolCallbackCleanupGroup(&callback_environ_, cleanup_group_, nullptr);
 
-            auto operator_work = CreateThreadpoolWork(dispatcher_operator, this, &callback_environ_);
+            auto operator_work = CreateThreadpoolWork(dispatcher_operator, this, &callback_environs_[static_cast<size_t>(colite::priority::HIGH)]);
             if (!operator_work) {
                 char error_message[48];
                 snprintf(error_message, sizeof(error_message), "Create Operator task failed. LastError: %lu", GetLastError());
                 cleanup();
-                throw std::runtime_error(error_message);
+                colite_throw(std::runtime_error(error_message));
             }
             SubmitThreadpoolWork(operator_work);
         }
 
         ~threadpool_dispatcher() override {
             cleanup();
+            // 所有回调都已结束，工作项都已归还；其 PTP_WORK 已随清理组关闭
+            reclaim_works();
+            for (auto& works : idle_works_) {
+                while (auto item = works) {
+                    works = item->next_;
+                    item->~work_item();
+                    colite::port::free(item);
+                }
+            }
+            for (auto& jobs : jobs_) {
+                while (auto job = jobs.pop_front()) {
+                    colite::detail::job_pool::destroy(*job);
+                }
+            }
+            // 恢复节点持有其协程状态，释放仍在队列中的节点
+            for (auto& resumes : resumes_) {
+                while (auto node = resumes.pop_front()) {
+                    release_resume_node(node);
+                }
+            }
         };
 
         threadpool_dispatcher(const threadpool_dispatcher&) = delete;
@@ -162,41 +116,184 @@ namespace colite::port {
         void dispatch(
             void *id,
             colite::port::time_duration time,
+            colite::priority priority,
             colite::callable<void()> callable
         ) override {
-            std::lock_guard locker { lock_ };
-            jobs_.emplace_back(id, time, std::move(callable));
+            if (time <= colite::port::time_duration(0) && put_local(id, priority, std::move(callable), nullptr)) {
+                return;
+            }
+            auto ready_time = job_pool::make_ready_time(time);
+            {
+                std::lock_guard locker { lock_ };
+                jobs_[static_cast<size_t>(priority)].push_back(pool_.acquire(id, ready_time, std::move(callable), colite::callable<bool()> {}));
+            }
+            wake_operator();
         }
 
         void dispatch(
             void *id,
             colite::port::time_duration time,
+            colite::priority priority,
             colite::callable<void()> callable,
             colite::callable<bool()> predicate
         ) override {
-            std::lock_guard locker { lock_ };
-            jobs_.emplace_back(id, time, std::move(callable), std::move(predicate));
+            // 条件在投递时已满足的任务（如子协程已同步完成时的完成任务）同样放入 LIFO 槽
+            if (time <= colite::port::time_duration(0) && current_worker_.owner_ == this && predicate()
+                && put_local(id, priority, std::move(callable), nullptr)) {
+                return;
+            }
+            auto ready_time = job_pool::make_ready_time(time);
+            {
+                std::lock_guard locker { lock_ };
+                jobs_[static_cast<size_t>(priority)].push_back(pool_.acquire(id, ready_time, std::move(callable), std::move(predicate)));
+            }
+            wake_operator();
+        }
+
+        void dispatch_resume(
+            const std::shared_ptr<base_coroutine_state>& state,
+            colite::port::time_duration time
+        ) override {
+            auto node = acquire_resume_node(state, time);
+            if (!node) {
+                colite::dispatcher::dispatch_resume(state, time);
+                return;
+            }
+            if (time <= colite::port::time_duration(0) && put_local(node->id_, state->get_priority(), colite::callable<void()> {}, node)) {
+                return;
+            }
+            {
+                std::lock_guard locker { lock_ };
+                resumes_[static_cast<size_t>(state->get_priority())].push_back(node);
+            }
+            wake_operator();
         }
 
         void cancel_jobs(void *id) override {
-            std::lock_guard locker { lock_ };
-            jobs_.remove_if([=] (const job& it) {
-                 return id == it.get_id();
-            });
+            // 被删除的任务在锁外析构，避免其捕获的对象在析构时重入调度器
+            job_list removed {};
+            colite::detail::resume_queue removed_resumes {};
+            std::vector<local_job, colite::allocator::allocator<local_job>> removed_locals {};
+            {
+                std::lock_guard locker { lock_ };
+                for (auto slot = slots_; slot; slot = slot->next_) {
+                    std::lock_guard slot_locker { slot->lock_ };
+                    if (slot->job_ && slot->job_->id_ == id) {
+                        removed_locals.emplace_back(std::move(*slot->job_));
+                        slot->job_.reset();
+                    }
+                }
+                for (auto& jobs : jobs_) {
+                    jobs.take_if(removed, SIZE_MAX, [id] (const colite::detail::job_header& job) { return job.id_ == id; });
+                }
+                for (auto& resumes : resumes_) {
+                    resumes.take_if(removed_resumes, SIZE_MAX, [id] (const colite::detail::resume_node& node) { return node.id_ == id; });
+                }
+            }
+            if (!removed.empty()) {
+                for (auto job = removed.front(); job; job = job->next_) {
+                    job_pool::destroy(*job);
+                }
+                std::lock_guard locker { lock_ };
+                pool_.recycle(removed);
+            }
+            while (auto node = removed_resumes.pop_front()) {
+                release_resume_node(node);
+            }
+            for (auto& job : removed_locals) {
+                if (job.resume_) {
+                    release_resume_node(job.resume_);
+                }
+            }
         }
 
     private:
-        TP_CALLBACK_ENVIRON callback_environ_ {};
+        using job_list = colite::detail::job_list;
+        using job_pool = colite::detail::job_pool;
+
+        // 每隔多少轮从最低优先级开始查找，避免较低优先级饿死
+        static constexpr size_t starvation_interval = 8;
+        // 一次回调中最多接着执行多少个 LIFO 槽中的任务，超出后剩余的任务移入共享队列，避免一条任务链独占工作线程
+        static constexpr size_t local_budget = 32;
+        // LIFO 槽中的任务等待超过该时长后，可被调度线程取走并提交给其他工作线程
+        static constexpr colite::port::time_duration steal_after = std::chrono::microseconds(50);
+        // 调度线程休眠时，仍有等待条件的任务或 LIFO 槽时的最长休眠时间（毫秒），以便重新检查
+        static constexpr DWORD recheck_interval = 1;
+
+        // LIFO 槽中的任务：resume_ 非空时为恢复任务，否则执行 callable_
+        struct local_job {
+            void *id_ = nullptr;
+            colite::priority priority_ = colite::priority::NORMAL;
+            colite::callable<void()> callable_ {};
+            colite::detail::resume_node *resume_ = nullptr;
+        };
+
+        // 复用的工作项：PTP_WORK 创建时绑定该对象与所属优先级的回调环境，执行完毕后归还，由调度线程再次提交
+        struct work_item {
+            threadpool_dispatcher& dispatcher_;
+            PTP_WORK work_ = nullptr;
+            colite::priority priority_ = colite::priority::NORMAL;
+            colite::callable<void()> callable_ {};
+            // 恢复任务的节点，非空时执行它而不是 callable_
+            colite::detail::resume_node *resume_ = nullptr;
+            work_item *next_ = nullptr;
+
+            // 替换任务：callable 的移动赋值要求两侧都非空，因此析构后重新构造
+            void set_callable(colite::callable<void()>&& callable) {
+                callable_.~callable();
+                ::new (&callable_) colite::callable<void()>(std::move(callable));
+            }
+        };
+
+        // 工作线程的 LIFO 槽：位于 job_callback 的栈上，只在该回调执行期间存在。
+        // 工作线程上投递的无延迟任务放入该槽，在当前任务结束后由同一线程接着执行，保持缓存局部性
+        struct local_slot {
+            colite::port::spin_lock lock_ {};
+            std::optional<local_job> job_ {};
+            // 调度线程第一次看到槽中任务的时间，入槽时不读取时钟
+            colite::port::time_point since_ = colite::port::time_point::min();
+            // 已登记的槽组成链表，供调度线程取走等待过久的任务，由调度器的 lock_ 保护
+            local_slot *prev_ = nullptr;
+            local_slot *next_ = nullptr;
+            bool registered_ = false;
+        };
+
+        // 当前线程正在执行的回调所属的调度器及其 LIFO 槽，不在回调中时为空
+        struct worker_context {
+            threadpool_dispatcher *owner_;
+            local_slot *slot_;
+        };
+
+        static inline thread_local worker_context current_worker_ { nullptr, nullptr };
+
+        TP_CALLBACK_ENVIRON callback_environs_[colite::priority_count] {};
         PTP_CLEANUP_GROUP cleanup_group_ = nullptr;
         PTP_POOL thread_pool_ = nullptr;
 
         std::atomic<bool> stop_request_ = false;
-
-        std::mutex lock_ {};
-        std::list<job, colite::allocator::allocator<job>> jobs_ {  };
+        // 调度线程没有可执行的任务时在该事件上休眠，及其是否正在休眠
+        HANDLE operator_wakeup_ = nullptr;
+        std::atomic<bool> operator_parked_ = false;
+
+        colite::port::spin_lock lock_ {};
+        // 任务记录的存储，由 lock_ 保护
+        job_pool pool_ {};
+        // 每个优先级一个队列
+        std::array<job_list, colite::priority_count> jobs_ {};
+        // 恢复协程的任务，节点内嵌在协程状态中
+        std::array<colite::detail::resume_queue, colite::priority_count> resumes_ {};
+        // 已登记的 LIFO 槽
+        local_slot *slots_ = nullptr;
+        // 空闲的工作项，每个优先级一个链表，只由调度线程访问
+        std::array<work_item*, colite::priority_count> idle_works_ {};
+        // 工作线程归还的工作项，调度线程一次取走整个链表
+        std::atomic<work_item*> returned_works_ = nullptr;
 
         void cleanup() {
             stop_request_ = true;
+            if (operator_wakeup_) {
+                SetEvent(operator_wakeup_);
+            }
             if (cleanup_group_) {
                 CloseThreadpoolCleanupGroupMembers(cleanup_group_, false, nullptr);
                 CloseThreadpoolCleanupGroup(cleanup_group_);
@@ -204,57 +301,341 @@ namespace colite::port {
             if (thread_pool_) {
                 CloseThreadpool(thread_pool_);
             }
+            if (operator_wakeup_) {
+                CloseHandle(operator_wakeup_);
+                operator_wakeup_ = nullptr;
+            }
+        }
+
+        // 唤醒休眠中的调度线程，调度线程未休眠时只是一次读取
+        void wake_operator() {
+            if (operator_parked_.load(std::memory_order_relaxed) && operator_parked_.exchange(false, std::memory_order_acq_rel)) {
+                SetEvent(operator_wakeup_);
+            }
+        }
+
+        /**
+         * @brief 调度线程在一轮中没有取得任务时，计算其可以休眠的时长，须持有 lock_
+         * @param now 当前时间
+         * @return 0 表示仍有就绪或即将就绪的任务，应继续查找；INFINITE 表示没有任何任务，直到投递新任务
+         */
+        auto idle_timeout(colite::port::time_point now) -> DWORD {
+            auto next = colite::port::time_point::max();
+            // 有等待条件的任务或已登记的 LIFO 槽，其就绪不一定伴随着投递，须定期重新检查
+            bool recheck = slots_ != nullptr;
+            for (auto slot = slots_; slot; slot = slot->next_) {
+                std::lock_guard slot_locker { slot->lock_ };
+                if (slot->job_) {
+                    return 0;
+                }
+            }
+            for (size_t i = 0; i < colite::priority_count; i++) {
+                for (auto job = jobs_[i].front(); job; job = job->next_) {
+                    if (job_pool::ready(*job, now)) {
+                        return 0;
+                    }
+                    if (job->ready_time_ > now) {
+                        next = std::min(next, job->ready_time_);
+                    } else {
+                        recheck = true;
+                    }
+                }
+                for (auto node = resumes_[i].front(); node; node = node->next_) {
+                    if (node->ready_time_ <= now) {
+                        return 0;
+                    }
+                    next = std::min(next, node->ready_time_);
+                }
+            }
+            DWORD timeout = INFINITE;
+            if (next != colite::port::time_point::max()) {
+                // 系统等待的精度为毫秒：向下取整提前醒来，不足 1ms 的部分继续查找
+                auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count();
+                if (ms == 0) {
+                    return 0;
+                }
+                timeout = static_cast<DWORD>(std::min<long long>(ms, INFINITE - 1));
+            }
+            return recheck ? std::min(timeout, recheck_interval) : timeout;
         }
 
         static VOID CALLBACK dispatcher_operator(PTP_CALLBACK_INSTANCE Instance, PVOID Parameter, PTP_WORK Work) {
             auto* self = static_cast<threadpool_dispatcher*>(Parameter);
 
             auto& jobs_ = self->jobs_;
+            auto& resumes_ = self->resumes_;
+            auto& pool_ = self->pool_;
             auto& lock_ = self->lock_;
             auto& stop_request = self->stop_request_;
 
+            // 已提交的任务记录，在下一次加锁时回收
+            job_list retired {};
+            size_t rounds = 0;
             while (!stop_request) {
-                std::optional<job> job = std::nullopt;
+                // 只在判断延迟任务与 LIFO 槽的等待时长时读取时钟，每轮至多一次
+                auto now = colite::port::time_point::min();
+                auto current = [&now] {
+                    if (now == colite::port::time_point::min()) {
+                        now = colite::port::current_time();
+                    }
+                    return now;
+                };
+                colite::detail::job_header *job = nullptr;
+                colite::detail::resume_node *resume = nullptr;
+                auto priority = colite::priority::NORMAL;
+                auto take_job = [&] (size_t i) -> bool {
+                    auto& jobs = jobs_[i];
+                    if (jobs.empty()) {
+                        return false;
+                    }
+                    auto front = jobs.front();
+                    if (job_pool::ready(*front, front->ready_time_ == colite::port::time_point::min() ? now : current())) {
+                        job = jobs.pop_front();
+                        return true;
+                    }
+                    jobs.push_back(jobs.pop_front());
+                    return false;
+                };
+                auto take_resume = [&] (size_t i) -> bool {
+                    auto& resumes = resumes_[i];
+                    if (resumes.empty()) {
+                        return false;
+                    }
+                    auto ready_time = resumes.front()->ready_time_;
+                    if (ready_time == colite::port::time_point::min() || ready_time <= current()) {
+                        resume = resumes.pop_front();
+                        return true;
+                    }
+                    resumes.push_back(resumes.pop_front());
+                    return false;
+                };
+                // 按优先级从高到低查找就绪的任务，每隔 starvation_interval 轮从最低优先级开始查找；
+                // 同一优先级中恢复任务与普通任务轮流优先
+                auto lowest_first = ++rounds % starvation_interval == 0;
+                auto resume_first = rounds % 2 == 0;
+                std::optional<local_job> stolen {};
+                DWORD idle = 0;
                 {
                     std::lock_guard locker { lock_ };
-                    if (jobs_.empty()) {
-                        continue;
+                    pool_.recycle(retired);
+                    // 先取走在 LIFO 槽中等待过久的任务，其所在的工作线程仍忙于当前任务
+                    for (auto slot = self->slots_; slot && !stolen; slot = slot->next_) {
+                        if (!slot->lock_.try_lock()) {
+                            continue;
+                        }
+                        if (slot->job_) {
+                            if (slot->since_ == colite::port::time_point::min()) {
+                                slot->since_ = current();
+                            } else if (current() - slot->since_ >= steal_after) {
+                                stolen.emplace(std::move(*slot->job_));
+                                slot->job_.reset();
+                            }
+                        }
+                        slot->lock_.unlock();
                     }
-                    if (jobs_.front().ready()) {
-                        job = std::move(jobs_.front());
-                        jobs_.pop_front();
-                    } else {
-                        jobs_.splice(jobs_.cend(), jobs_, jobs_.cbegin());
+                    for (size_t n = 0; n < colite::priority_count && !stolen; n++) {
+                        auto i = lowest_first ? colite::priority_count - 1 - n : n;
+                        if (resume_first ? (take_resume(i) || take_job(i)) : (take_job(i) || take_resume(i))) {
+                            priority = static_cast<colite::priority>(i);
+                            break;
+                        }
+                    }
+                    if (!stolen && !job && !resume) {
+                        idle = self->idle_timeout(current());
+                        if (idle != 0) {
+                            self->operator_parked_.store(true, std::memory_order_release);
+                        }
                     }
                 }
+                if (idle != 0) {
+                    // 没有可执行的任务时休眠到下一个延迟任务，有新任务投递或工作线程完成任务时被唤醒
+                    WaitForSingleObject(self->operator_wakeup_, idle);
+                    self->operator_parked_.store(false, std::memory_order_relaxed);
+                    continue;
+                }
+                if (stolen) {
+                    self->start_dispatch(stolen->id_, stolen->priority_, std::move(stolen->callable_), stolen->resume_);
+                }
                 if (job) {
-                    self->start_dispatch(job->get_id(), std::move(job).value().get_callable());
+                    auto callable = std::move(job->payload_->callable_);
+                    job_pool::destroy(*job);
+                    retired.push_back(job);
+                    self->start_dispatch(job->id_, priority, std::move(callable));
+                } else if (resume) {
+                    self->start_dispatch(resume->id_, priority, colite::callable<void()> {}, resume);
                 }
             }
         }
 
+        /**
+         * @brief 将任务交给线程池执行，只由调度线程调用。优先复用该优先级空闲的工作项，没有时才创建新的 PTP_WORK
+         */
         void start_dispatch(
             void *id,
-            colite::callable<void()> callable
+            colite::priority priority,
+            colite::callable<void()> callable,
+            colite::detail::resume_node *resume = nullptr
         ) {
-            auto* args = (job_task_args*)colite::port::calloc(1, sizeof(job_task_args));
+            auto index = static_cast<size_t>(priority);
+            if (!idle_works_[index]) {
+                reclaim_works();
+            }
+            auto item = idle_works_[index];
+            if (item) {
+                idle_works_[index] = item->next_;
+            } else {
+                item = static_cast<work_item*>(colite::port::calloc(1, sizeof(work_item)));
+                ::new (item) work_item { .dispatcher_ = *this, .priority_ = priority };
+                item->work_ = CreateThreadpoolWork(job_callback, item, &callback_environs_[index]);
+                colite_assert(item->work_);
+            }
+            item->next_ = nullptr;
+            item->set_callable(std::move(callable));
+            item->resume_ = resume;
+            SubmitThreadpoolWork(item->work_);
+        }
 
-            auto work = CreateThreadpoolWork(job_callback, args, &callback_environ_);
-            colite_assert(work);
+        // 取回工作线程归还的工作项，按优先级放回空闲链表，只由调度线程调用
+        void reclaim_works() {
+            auto item = returned_works_.exchange(nullptr, std::memory_order_acquire);
+            while (item) {
+                auto next = item->next_;
+                auto& works = idle_works_[static_cast<size_t>(item->priority_)];
+                item->next_ = works;
+                works = item;
+                item = next;
+            }
+        }
 
-            ::new (args) job_task_args {
-                .dispatcher_ = *this,
-                .job_ = threadpool_job(id, args, work),
-                .callable_ = std::move(callable)
-            };
-            SubmitThreadpoolWork(work);
+        // 工作线程归还执行完毕的工作项，之后不再访问它：调度线程可能立即再次提交
+        void return_work(work_item *item) {
+            auto head = returned_works_.load(std::memory_order_relaxed);
+            do {
+                item->next_ = head;
+            } while (!returned_works_.compare_exchange_weak(head, item, std::memory_order_release, std::memory_order_relaxed));
         }
 
         static VOID CALLBACK job_callback(PTP_CALLBACK_INSTANCE Instance, PVOID Parameter, PTP_WORK Work) {
-            auto* args = static_cast<job_task_args*>(Parameter);
-            args->callable_();
-            args->~job_task_args();
-            colite::port::free(args);
+            auto* item = static_cast<work_item*>(Parameter);
+            auto& self = item->dispatcher_;
+            local_slot slot {};
+            auto previous = std::exchange(current_worker_, worker_context { &self, &slot });
+            job_scope scope { self };
+            if (item->resume_) {
+                run_resume_node(item->resume_);
+            } else {
+                item->callable_();
+                // 在归还之前析构任务捕获的对象
+                item->set_callable(colite::callable<void()> {});
+            }
+            self.return_work(item);
+            // 接着执行本线程放入 LIFO 槽中的任务
+            for (size_t n = 0; n < local_budget; n++) {
+                std::optional<local_job> job {};
+                {
+                    std::lock_guard locker { slot.lock_ };
+                    if (!slot.job_) {
+                        break;
+                    }
+                    job.emplace(std::move(*slot.job_));
+                    slot.job_.reset();
+                }
+                if (job->resume_) {
+                    run_resume_node(job->resume_);
+                } else {
+                    job->callable_();
+                }
+            }
+            current_worker_ = previous;
+            self.retire_slot(slot);
+            // 本次执行可能使等待条件的任务（如等待子协程结束的完成任务）就绪
+            self.wake_operator();
+        }
+
+        /**
+         * @brief 当前线程正在执行本调度器的任务时，将任务放入该线程的 LIFO 槽，槽中原有的任务移入共享队列
+         * @return 当前线程不是本调度器的工作线程时返回 false，任务保持不变
+         */
+        auto put_local(
+            void *id,
+            colite::priority priority,
+            colite::callable<void()>&& callable,
+            colite::detail::resume_node *resume
+        ) -> bool {
+            auto& worker = current_worker_;
+            if (worker.owner_ != this) {
+                return false;
+            }
+            auto& slot = *worker.slot_;
+            std::optional<local_job> evicted {};
+            {
+                std::lock_guard locker { slot.lock_ };
+                if (slot.job_) {
+                    evicted.emplace(std::move(*slot.job_));
+                    slot.job_.reset();
+                }
+                slot.job_.emplace(local_job { id, priority, std::move(callable), resume });
+                slot.since_ = colite::port::time_point::min();
+            }
+            // 槽只由其所属线程登记，registered_ 的读取不需要加锁
+            if (evicted || !slot.registered_) {
+                std::lock_guard locker { lock_ };
+                if (!slot.registered_) {
+                    slot.registered_ = true;
+                    slot.next_ = slots_;
+                    if (slots_) {
+                        slots_->prev_ = &slot;
+                    }
+                    slots_ = &slot;
+                }
+                if (evicted) {
+                    push_shared(std::move(*evicted));
+                }
+            }
+            wake_operator();
+            return true;
+        }
+
+        /**
+         * @brief 回调结束时注销 LIFO 槽，槽中剩余的任务移入共享队列
+         */
+        void retire_slot(local_slot& slot) {
+            std::optional<local_job> left {};
+            {
+                std::lock_guard locker { slot.lock_ };
+                if (slot.job_) {
+                    left.emplace(std::move(*slot.job_));
+                    slot.job_.reset();
+                }
+            }
+            if (!left && !slot.registered_) {
+                return;
+            }
+            std::lock_guard locker { lock_ };
+            if (left) {
+                push_shared(std::move(*left));
+            }
+            if (slot.registered_) {
+                if (slot.prev_) {
+                    slot.prev_->next_ = slot.next_;
+                } else {
+                    slots_ = slot.next_;
+                }
+                if (slot.next_) {
+                    slot.next_->prev_ = slot.prev_;
+                }
+                slot.registered_ = false;
+            }
+        }
+
+        // 将 LIFO 槽中的任务移入共享队列，调用者须持有 lock_
+        void push_shared(local_job&& job) {
+            auto i = static_cast<size_t>(job.priority_);
+            if (job.resume_) {
+                resumes_[i].push_back(job.resume_);
+            } else {
+                jobs_[i].push_back(pool_.acquire(job.id_, colite::port::time_point::min(), std::move(job.callable_), colite::callable<bool()> {}));
+            }
         }
     };
 }
\ No newline at end of file
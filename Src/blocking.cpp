@@ -0,0 +1,73 @@
+#include <thread>
+#include "colite/blocking.h"
+
+colite::blocking_pool::blocking_pool(options options): options_(options) {
+    colite_assert(options_.max_threads > 0);
+}
+
+colite::blocking_pool::~blocking_pool() {
+    std::unique_lock locker { lock_ };
+    stop_request_ = true;
+    task_available_.notify_all();
+    all_exited_.wait(locker, [this] { return threads_ == 0; });
+}
+
+auto colite::blocking_pool::submit(colite::callable<void()> task) -> bool {
+    std::lock_guard locker { lock_ };
+    if (stop_request_ || tasks_.size() >= options_.max_queue) {
+        return false;
+    }
+    // 排队的任务多于能够接手的线程（空闲的与正在启动的）时扩容。先创建线程再入队与计数，
+    // 创建失败时抛出的 std::system_error 不会留下无人执行的任务或多计的线程
+    while (tasks_.size() + 1 > idle_threads_ + starting_threads_ && threads_ < options_.max_threads) {
+        std::thread([this] { worker(); }).detach();
+        threads_++;
+        starting_threads_++;
+    }
+    tasks_.emplace_back(std::move(task));
+    if (idle_threads_ > 0) {
+        task_available_.notify_one();
+    }
+    return true;
+}
+
+auto colite::blocking_pool::thread_count() -> size_t {
+    std::lock_guard locker { lock_ };
+    return threads_;
+}
+
+auto colite::blocking_pool::default_pool() -> blocking_pool& {
+    static blocking_pool pool {};
+    return pool;
+}
+
+void colite::blocking_pool::worker() {
+    std::unique_lock locker { lock_ };
+    starting_threads_--;
+    while (true) {
+        if (tasks_.empty()) {
+            if (stop_request_) {
+                break;
+            }
+            idle_threads_++;
+            auto has_task = task_available_.wait_for(locker, options_.keep_alive, [this] {
+                return !tasks_.empty() || stop_request_;
+            });
+            idle_threads_--;
+            // 空闲超时，回收该线程
+            if (!has_task) {
+                break;
+            }
+            continue;
+        }
+        auto task = std::move(tasks_.front());
+        tasks_.pop_front();
+        locker.unlock();
+        task();
+        locker.lock();
+    }
+    threads_--;
+    if (threads_ == 0) {
+        all_exited_.notify_all();
+    }
+}
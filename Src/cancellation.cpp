@@ -0,0 +1,50 @@
+#include <vector>
+#include "colite/cancellation.h"
+#include "colite/dispatchers.h"
+
+void colite::cancellation_state::attach(base_coroutine_state *state) {
+    std::lock_guard locker { lock_ };
+    state->cancellation_prev_ = nullptr;
+    state->cancellation_next_ = head_;
+    if (head_) {
+        head_->cancellation_prev_ = state;
+    }
+    head_ = state;
+}
+
+void colite::cancellation_state::detach(base_coroutine_state *state) {
+    std::lock_guard locker { lock_ };
+    if (state->cancellation_prev_) {
+        state->cancellation_prev_->cancellation_next_ = state->cancellation_next_;
+    } else {
+        head_ = state->cancellation_next_;
+    }
+    if (state->cancellation_next_) {
+        state->cancellation_next_->cancellation_prev_ = state->cancellation_prev_;
+    }
+    state->cancellation_prev_ = nullptr;
+    state->cancellation_next_ = nullptr;
+}
+
+void colite::cancellation_state::cancel() {
+    if (canceled_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    // 在锁内取得强引用，在锁外取消：销毁协程帧时会析构其子协程的状态，从而重入 detach
+    std::vector<std::shared_ptr<base_coroutine_state>, colite::allocator::allocator<std::shared_ptr<base_coroutine_state>>> states {};
+    {
+        std::lock_guard locker { lock_ };
+        for (auto it = head_; it; it = it->cancellation_next_) {
+            // 正在析构的状态无法取得强引用，跳过即可
+            if (auto state = it->weak_from_this().lock()) {
+                states.emplace_back(std::move(state));
+            }
+        }
+    }
+    for (auto& state : states) {
+        // 尚未启动的协程在启动后的第一个 co_await 处观察到取消
+        if (state->get_status() != coroutine_status::CREATED) {
+            colite::dispatcher::request_cancel(*state);
+        }
+    }
+}
@@ -1,14 +1,351 @@
+#include <iterator>
 #include "colite/dispatchers.h"
 #include "colite/suspend.h"
 
-static auto nop_coroutine() -> colite::suspend<> {
+thread_local colite::dispatcher::running_coroutine colite::dispatcher::current_ {};
+
+auto colite::dispatcher::nop_coroutine() -> colite::suspend<> {
     co_return;
 }
 
-auto colite::dispatcher::sleep(colite::port::time_duration time) -> colite::suspend<> {
-    return launch(nop_coroutine(), time);
+auto colite::dispatcher::sleep(
+    colite::port::time_duration time,
+    colite::priority priority
+) -> colite::suspend<> {
+    return launch_internal(nop_coroutine(), priority, time);
 }
 
 void colite::dispatcher::cancel(std::coroutine_handle<> handle) {
     cancel_jobs(handle.address());
 }
+
+void colite::dispatcher::resume(const std::shared_ptr<base_coroutine_state>& state) {
+    if (state->is_cancel_requested()) {
+        if (state->request_cancel()) {
+            destroy_canceled(*state);
+        }
+        return;
+    }
+    // 协程在 BLOCK 策略下超出上限启动了新任务，等到有空位之后才恢复
+    if (state->get_capacity_gate() && hold_for_capacity(state)) {
+        return;
+    }
+    if (!state->try_resume()) {
+        return;
+    }
+    // 时间片在第一次调用 should_yield() 时才开始计算，恢复协程时不读取时钟
+    // 协程可能在普通任务中被恢复（如启动任务），结束后还原为该任务的上下文
+    auto previous = std::exchange(current_, running_coroutine { .state_ = state.get(), .dispatcher_ = state->get_dispatcher() });
+    state->get_handle().resume();
+    current_ = previous;
+    // 协程运行期间被请求取消的，在其挂起之后完成取消
+    if (state->is_cancel_requested() && state->transition(coroutine_status::SUSPENDED, coroutine_status::CANCELED)) {
+        destroy_canceled(*state);
+    }
+}
+
+void colite::dispatcher::schedule_resume(
+    const std::shared_ptr<base_coroutine_state>& state,
+    colite::port::time_duration delay
+) {
+    auto dispatcher = state->get_dispatcher();
+    colite_assert(dispatcher);
+    dispatcher->dispatch_resume(state, delay);
+}
+
+void colite::dispatcher::dispatch_resume(
+    const std::shared_ptr<base_coroutine_state>& state,
+    colite::port::time_duration time
+) {
+    dispatch(state->get_handle().address(), time, state->get_priority(), [state] {
+        resume(state);
+    });
+}
+
+auto colite::dispatcher::acquire_resume_node(
+    const std::shared_ptr<base_coroutine_state>& state,
+    colite::port::time_duration time
+) -> detail::resume_node* {
+    auto node = &state->get_resume_node();
+    if (node->queued_.exchange(true, std::memory_order_acquire)) {
+        return nullptr;
+    }
+    node->next_ = nullptr;
+    node->id_ = state->get_handle().address();
+    // 无延迟的任务不需要读取时钟，总是就绪
+    node->ready_time_ = time <= colite::port::time_duration(0)
+        ? colite::port::time_point::min()
+        : colite::port::current_time() + time;
+    node->owner_ = state;
+    return node;
+}
+
+void colite::dispatcher::run_resume_node(detail::resume_node *node) {
+    // 先释放节点，协程在本次运行中可以再次使用它
+    auto state = std::move(node->owner_);
+    node->queued_.store(false, std::memory_order_release);
+    resume(state);
+}
+
+void colite::dispatcher::release_resume_node(detail::resume_node *node) {
+    // 节点随协程状态一起析构，在 state 析构之前释放节点
+    auto state = std::move(node->owner_);
+    node->queued_.store(false, std::memory_order_release);
+}
+
+auto colite::dispatcher::should_yield() -> bool {
+    auto& running = current_;
+    if (!running.dispatcher_) {
+        return false;
+    }
+    // 以调度器自己的时钟计算，仿真调度器的时间片随虚拟时间流逝
+    auto now = running.dispatcher_->clock();
+    if (running.slice_start_ == colite::port::time_point::max()) {
+        running.slice_start_ = now;
+        return false;
+    }
+    return now - running.slice_start_ >= running.dispatcher_->time_slice_;
+}
+
+auto colite::dispatcher::current_clock() -> colite::port::time_point {
+    if (current_.dispatcher_) {
+        return current_.dispatcher_->clock();
+    }
+    return colite::port::current_time();
+}
+
+auto colite::dispatcher::is_cancellation_requested() -> bool {
+    return current_.state_ && current_.state_->is_cancellation_requested();
+}
+
+void colite::dispatcher::destroy_canceled(base_coroutine_state& state) {
+    colite_assert(state.get_status() == coroutine_status::CANCELED);
+    auto handle = state.get_handle();
+    auto dispatcher = state.get_dispatcher();
+    if (dispatcher) {
+        dispatcher->cancel(handle);
+    }
+    handle.destroy();
+    // 完成任务已随上面的 cancel 一并删除，由这里恢复等待者，等待者在 co_await 处观察到取消
+    complete_awaiter(state);
+}
+
+void colite::dispatcher::complete_awaiter(base_coroutine_state& state) {
+    auto awaiter = state.take_awaiter();
+    if (!awaiter) {
+        return;
+    }
+    if (auto completion = state.get_completion()) {
+        completion(state, awaiter);
+    } else {
+        schedule_resume(awaiter);
+    }
+}
+
+void colite::dispatcher::request_cancel(base_coroutine_state& state) {
+    if (state.request_cancel()) {
+        destroy_canceled(state);
+    }
+}
+
+colite::detail::admission::~admission() {
+    owner_->release(*this);
+}
+
+void colite::dispatcher::set_queue_limits(const queue_limits& limits) {
+    std::vector<std::shared_ptr<base_coroutine_state>> waiters {};
+    {
+        std::lock_guard locker { admission_lock_ };
+        limits_ = limits;
+        auto bounded = limits.max_jobs > 0;
+        for (auto it : limits.max_jobs_per_priority) {
+            bounded = bounded || it > 0;
+        }
+        bounded_.store(bounded, std::memory_order_release);
+        // 上限可能被放宽，唤醒所有等待者重新检查
+        for (auto& it : capacity_waiters_) {
+            std::move(it.begin(), it.end(), std::back_inserter(waiters));
+            it.clear();
+        }
+        if (blocked_threads_ > 0) {
+            capacity_released_.notify_all();
+        }
+    }
+    for (auto& it : waiters) {
+        schedule_resume(it);
+    }
+}
+
+auto colite::dispatcher::get_queue_limits() -> queue_limits {
+    std::lock_guard locker { admission_lock_ };
+    return limits_;
+}
+
+auto colite::dispatcher::get_queue_stats() const -> queue_stats {
+    return queue_stats {
+        .full = stats_.full.load(std::memory_order_relaxed),
+        .rejected = stats_.rejected.load(std::memory_order_relaxed),
+        .shed = stats_.shed.load(std::memory_order_relaxed),
+        .blocked = stats_.blocked.load(std::memory_order_relaxed)
+    };
+}
+
+auto colite::dispatcher::pending_jobs(colite::priority priority) -> size_t {
+    std::lock_guard locker { admission_lock_ };
+    return pending_[static_cast<size_t>(priority)];
+}
+
+auto colite::dispatcher::has_capacity(colite::priority priority) const -> bool {
+    auto index = static_cast<size_t>(priority);
+    if (limits_.max_jobs > 0 && pending_total_ >= limits_.max_jobs) {
+        return false;
+    }
+    auto limit = limits_.max_jobs_per_priority[index];
+    return limit == 0 || pending_[index] < limit;
+}
+
+auto colite::dispatcher::pick_victim(colite::priority priority) -> detail::admission* {
+    auto index = static_cast<size_t>(priority);
+    auto per_priority_full = limits_.max_jobs_per_priority[index] > 0 && pending_[index] >= limits_.max_jobs_per_priority[index];
+    // 本优先级已满时，只有丢弃本优先级的任务才能腾出空位
+    if (limits_.policy == overload_policy::SHED_OLDEST || per_priority_full) {
+        if (admitted_head_[index]) {
+            return admitted_head_[index];
+        }
+    }
+    // 从最低优先级找起，不丢弃比新任务优先级更高的任务
+    for (auto i = priority_count; i > index; i--) {
+        if (admitted_head_[i - 1]) {
+            return admitted_head_[i - 1];
+        }
+    }
+    return nullptr;
+}
+
+void colite::dispatcher::unlink(detail::admission& admission) {
+    auto index = static_cast<size_t>(admission.priority_);
+    if (admission.prev_) {
+        admission.prev_->next_ = admission.next_;
+    } else {
+        admitted_head_[index] = admission.next_;
+    }
+    if (admission.next_) {
+        admission.next_->prev_ = admission.prev_;
+    } else {
+        admitted_tail_[index] = admission.prev_;
+    }
+    admission.prev_ = admission.next_ = nullptr;
+    admission.linked_ = false;
+    pending_[index]--;
+    pending_total_--;
+}
+
+auto colite::dispatcher::admit(
+    colite::priority priority,
+    std::weak_ptr<base_coroutine_state> coroutine
+) -> colite::expected<std::shared_ptr<detail::admission>, errc> {
+    if (!bounded_.load(std::memory_order_acquire)) {
+        return nullptr;
+    }
+    auto index = static_cast<size_t>(priority);
+    auto admission = std::allocate_shared<detail::admission, colite::allocator::allocator<std::byte>>({}, this, priority, std::move(coroutine));
+    // 被丢弃的任务，在解锁之后删除
+    std::shared_ptr<base_coroutine_state> shed_coroutine = nullptr;
+    std::shared_ptr<detail::admission> shed_job = nullptr;
+    {
+        std::unique_lock locker { admission_lock_ };
+        if (!has_capacity(priority)) {
+            stats_.full.fetch_add(1, std::memory_order_relaxed);
+            switch (limits_.policy) {
+                case overload_policy::REJECT:
+                    stats_.rejected.fetch_add(1, std::memory_order_relaxed);
+                    return colite::unexpected(errc::queue_full);
+                case overload_policy::BLOCK:
+                    if (current_.state_) {
+                        // 在协程中不阻塞线程：放行新任务，发起调用的协程在有空位之后才被恢复
+                        stats_.blocked.fetch_add(1, std::memory_order_relaxed);
+                        current_.state_->close_capacity_gate(this, priority);
+                    } else if (current_.dispatcher_ != this) {
+                        // 等待名额归还；在本调度器的普通任务中阻塞会使调度器无法腾出空位，只能放行
+                        stats_.blocked.fetch_add(1, std::memory_order_relaxed);
+                        blocked_threads_++;
+                        capacity_released_.wait(locker, [this, priority] {
+                            return has_capacity(priority);
+                        });
+                        blocked_threads_--;
+                    }
+                    break;
+                case overload_policy::SHED_OLDEST:
+                case overload_policy::SHED_LOWEST:
+                    stats_.shed.fetch_add(1, std::memory_order_relaxed);
+                    if (auto victim = pick_victim(priority)) {
+                        victim->shed_.store(true, std::memory_order_release);
+                        unlink(*victim);
+                        // 协程被取消时其任务随之删除；普通任务以凭据的地址为 id，删除之前凭据须保持存活，以免地址被复用
+                        shed_coroutine = victim->coroutine_.lock();
+                        if (!shed_coroutine) {
+                            shed_job = victim->weak_from_this().lock();
+                        }
+                    } else {
+                        // 没有可以丢弃的任务时，丢弃新任务本身，调用者不将其入队
+                        admission->shed_.store(true, std::memory_order_relaxed);
+                        return admission;
+                    }
+                    break;
+            }
+        }
+        admission->prev_ = admitted_tail_[index];
+        if (admitted_tail_[index]) {
+            admitted_tail_[index]->next_ = admission.get();
+        } else {
+            admitted_head_[index] = admission.get();
+        }
+        admitted_tail_[index] = admission.get();
+        admission->linked_ = true;
+        pending_[index]++;
+        pending_total_++;
+    }
+    if (shed_coroutine) {
+        request_cancel(*shed_coroutine);
+    } else if (shed_job) {
+        cancel_jobs(shed_job.get());
+    }
+    return admission;
+}
+
+void colite::dispatcher::release(detail::admission& admission) {
+    std::shared_ptr<base_coroutine_state> waiter = nullptr;
+    {
+        std::lock_guard locker { admission_lock_ };
+        if (!admission.linked_) {
+            return;
+        }
+        unlink(admission);
+        if (blocked_threads_ > 0) {
+            capacity_released_.notify_all();
+        }
+        // 按优先级从高到低唤醒一个已有空位的等待者
+        for (size_t i = 0; i < priority_count && !waiter; i++) {
+            auto& waiters = capacity_waiters_[i];
+            if (!waiters.empty() && has_capacity(static_cast<colite::priority>(i))) {
+                waiter = std::move(waiters.front());
+                waiters.erase(waiters.begin());
+            }
+        }
+    }
+    if (waiter) {
+        schedule_resume(waiter);
+    }
+}
+
+auto colite::dispatcher::hold_for_capacity(const std::shared_ptr<base_coroutine_state>& state) -> bool {
+    auto owner = state->get_capacity_gate();
+    auto priority = state->get_capacity_gate_priority();
+    std::lock_guard locker { owner->admission_lock_ };
+    if (!owner->bounded_.load(std::memory_order_relaxed) || owner->has_capacity(priority)) {
+        state->open_capacity_gate();
+        return false;
+    }
+    owner->capacity_waiters_[static_cast<size_t>(priority)].emplace_back(state);
+    return true;
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <coroutine>
+#include <type_traits>
+#include "colite/callable.h"
+#include "colite/port.h"
+#include "colite/traits.h"
+#include "colite/expected.h"
+#include "colite/state.h"
+#include "colite/dispatchers.h"
+#include "colite/suspend.h"
+
+namespace colite {
+    /**
+     * @brief 具体调度器的 CRTP 基类：通过具体类型调用 launch、sleep、post 时，入队直接调用 Derived::dispatch，
+     *        不经过虚函数，可以被内联；以 colite::dispatcher& 使用时仍经过虚函数。
+     *        Derived 须为 final，并将 basic_dispatcher<Derived> 声明为友元
+     * @tparam Derived 具体调度器类型
+     */
+    template<typename Derived>
+    class basic_dispatcher: public dispatcher {
+        friend class colite::dispatcher;
+
+    public:
+        template<typename Coro>
+            requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
+        auto launch(
+            Coro&& coroutine,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> decltype(auto) {
+            return launch_on(derived(), std::forward<Coro>(coroutine), duration);
+        }
+
+        template<typename Coro>
+            requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
+        auto launch(
+            Coro&& coroutine,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> decltype(auto) {
+            colite_assert(coroutine.state_);
+            coroutine.state_->set_priority(priority);
+            return launch(std::forward<Coro>(coroutine), duration);
+        }
+
+        auto sleep(
+            colite::port::time_duration time,
+            colite::priority priority = colite::priority::NORMAL
+        ) -> colite::suspend<> {
+            auto coroutine = nop_coroutine();
+            coroutine.state_->set_priority(priority);
+            return start_on(derived(), std::move(coroutine), time, nullptr);
+        }
+
+        void post(
+            colite::callable<void()> callable,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) {
+            post_on(derived(), std::move(callable), colite::priority::NORMAL, duration);
+        }
+
+        void post(
+            colite::callable<void()> callable,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) {
+            post_on(derived(), std::move(callable), priority, duration);
+        }
+
+        template<typename T>
+        auto try_launch(
+            colite::suspend<T>&& coroutine,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> colite::expected<colite::suspend<T>, errc> {
+            return try_launch_on(derived(), std::move(coroutine), duration);
+        }
+
+        template<typename T>
+        auto try_launch(
+            colite::suspend<T>&& coroutine,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> colite::expected<colite::suspend<T>, errc> {
+            colite_assert(coroutine.state_);
+            coroutine.state_->set_priority(priority);
+            return try_launch_on(derived(), std::move(coroutine), duration);
+        }
+
+        auto try_post(
+            colite::callable<void()> callable,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> colite::expected<void, errc> {
+            return try_post_on(derived(), std::move(callable), colite::priority::NORMAL, duration);
+        }
+
+        auto try_post(
+            colite::callable<void()> callable,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> colite::expected<void, errc> {
+            return try_post_on(derived(), std::move(callable), priority, duration);
+        }
+
+    protected:
+        void enqueue(void *id, colite::port::time_duration time, colite::priority priority, colite::callable<void()> callable) {
+            derived().Derived::dispatch(id, time, priority, std::move(callable));
+        }
+
+        void enqueue(void *id, colite::port::time_duration time, colite::priority priority, colite::callable<void()> callable, colite::callable<bool()> predicate) {
+            derived().Derived::dispatch(id, time, priority, std::move(callable), std::move(predicate));
+        }
+
+    private:
+        auto derived() -> Derived& {
+            return static_cast<Derived&>(*this);
+        }
+    };
+}
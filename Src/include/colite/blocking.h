@@ -0,0 +1,196 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <coroutine>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include "colite/allocator.h"
+#include "colite/callable.h"
+#include "colite/port.h"
+#include "colite/state.h"
+#include "colite/expected.h"
+#include "colite/dispatchers.h"
+
+namespace colite {
+    // 弹性的阻塞任务线程池：有任务且没有空闲线程时按需创建线程（不超过上限），空闲超时的线程自动退出
+    class blocking_pool {
+    public:
+        struct options {
+            // 线程数上限
+            size_t max_threads = 64;
+            // 排队任务数上限，超过时 submit 失败
+            size_t max_queue = 4096;
+            // 空闲线程的存活时间
+            std::chrono::milliseconds keep_alive = std::chrono::seconds(10);
+        };
+
+        explicit blocking_pool(options options);
+        blocking_pool(): blocking_pool(options {}) {  }
+        ~blocking_pool();
+
+        blocking_pool(const blocking_pool&) = delete;
+        blocking_pool& operator=(const blocking_pool&) = delete;
+
+        /**
+         * @brief 提交任务，可在任意线程调用
+         * @param task 任务
+         * @return 若队列已满则返回 false
+         */
+        auto submit(colite::callable<void()> task) -> bool;
+
+        /**
+         * @brief 获取当前的线程数
+         * @return
+         */
+        [[nodiscard]]
+        auto thread_count() -> size_t;
+
+        /**
+         * @brief 获取默认的阻塞任务线程池
+         * @return
+         */
+        static auto default_pool() -> blocking_pool&;
+
+    private:
+        using task_queue = std::deque<colite::callable<void()>, colite::allocator::allocator<colite::callable<void()>>>;
+
+        const options options_;
+        std::mutex lock_ {};
+        std::condition_variable task_available_ {};
+        std::condition_variable all_exited_ {};
+        task_queue tasks_ {};
+        size_t threads_ = 0;
+        size_t idle_threads_ = 0;
+        // 已创建、尚未开始取任务的线程数
+        size_t starting_threads_ = 0;
+        bool stop_request_ = false;
+
+        void worker();
+    };
+
+    namespace detail {
+        /**
+         * @brief colite::blocking 与 colite::try_blocking 的等待体
+         * @tparam Fn 阻塞调用
+         * @tparam Checked 为 true 时线程池队列已满以 errc::blocking_pool_full 返回，否则抛出
+         */
+        template<typename Fn, bool Checked>
+        class blocking_awaiter {
+        public:
+            using result_type = std::invoke_result_t<Fn>;
+            using resume_type = std::conditional_t<Checked, colite::expected<result_type, errc>, result_type>;
+
+            blocking_awaiter(Fn fn, blocking_pool& pool): fn_(std::move(fn)), pool_(pool) {  }
+
+            [[nodiscard]]
+            auto await_ready() const noexcept -> bool { return false; }
+
+            template<typename Promise>
+            auto await_suspend(std::coroutine_handle<Promise> handle) -> bool {
+                std::shared_ptr<base_coroutine_state> state = handle.promise().get_state();
+                auto call = std::allocate_shared<blocking_call, colite::allocator::allocator<std::byte>>({}, std::move(fn_));
+                call_ = call;
+                auto& pool = pool_;
+                auto task = [call, state] {
+                    call->run();
+                    dispatcher::schedule_resume(state);
+                };
+                // 挂起之后当前对象可能随协程帧一起被销毁，之后只使用局部变量
+                state->suspended("blocking", call.get());
+                if (pool.submit(std::move(task))) {
+                    return true;
+                }
+                // 队列已满：重新取得运行协程的权利之后不再挂起，由 await_resume 报告；在此期间被取消的保持挂起由取消者销毁
+                if (!state->try_resume()) {
+                    return true;
+                }
+                rejected_ = true;
+                return false;
+            }
+
+            auto await_resume() -> resume_type {
+                if (rejected_) {
+                    if constexpr (Checked) {
+                        return colite::unexpected(errc::blocking_pool_full);
+                    } else {
+                        colite_throw(std::runtime_error("colite::blocking: the blocking pool queue is full."));
+                    }
+                }
+#ifndef COLITE_NO_EXCEPTIONS
+                if (call_->exception_ptr_) {
+                    std::rethrow_exception(call_->exception_ptr_);
+                }
+#endif
+                if constexpr (!std::is_void_v<result_type>) {
+                    return std::move(call_->value_).value();
+                } else if constexpr (Checked) {
+                    return {};
+                }
+            }
+
+        private:
+            // 阻塞调用与其结果，由协程与线程池共享
+            struct blocking_call {
+                explicit blocking_call(Fn fn): fn_(std::move(fn)) {  }
+
+                void run() {
+#ifndef COLITE_NO_EXCEPTIONS
+                    try {
+#endif
+                        if constexpr (std::is_void_v<result_type>) {
+                            std::invoke(fn_);
+                        } else {
+                            value_.emplace(std::invoke(fn_));
+                        }
+#ifndef COLITE_NO_EXCEPTIONS
+                    } catch (...) {
+                        exception_ptr_ = std::current_exception();
+                    }
+#endif
+                }
+
+                Fn fn_;
+                std::conditional_t<std::is_void_v<result_type>, bool, std::optional<result_type>> value_ {};
+#ifndef COLITE_NO_EXCEPTIONS
+                std::exception_ptr exception_ptr_ {};
+#endif
+            };
+
+            Fn fn_;
+            blocking_pool& pool_;
+            std::shared_ptr<blocking_call> call_ {};
+            bool rejected_ = false;
+        };
+    }
+
+    /**
+     * @brief 在阻塞任务线程池上执行阻塞调用，完成后在原调度器上恢复当前协程：
+     *        `auto r = co_await colite::blocking([] { return legacy_call(); });`
+     * @param fn 阻塞调用
+     * @param pool 线程池，默认为 blocking_pool::default_pool()
+     * @return 等待体，`co_await` 的结果为 fn 的返回值，fn 抛出的异常在协程中重新抛出；线程池队列已满时抛出 std::runtime_error
+     */
+    template<typename Fn>
+    auto blocking(Fn&& fn, blocking_pool& pool = blocking_pool::default_pool()) {
+        return detail::blocking_awaiter<std::decay_t<Fn>, false>(std::forward<Fn>(fn), pool);
+    }
+
+    /**
+     * @brief 与 colite::blocking 相同，但线程池队列已满时不抛出异常：
+     *        `auto r = co_await colite::try_blocking([] { return legacy_call(); }); if (!r) { ... }`
+     * @param fn 阻塞调用
+     * @param pool 线程池，默认为 blocking_pool::default_pool()
+     * @return 等待体，`co_await` 的结果为 colite::expected<fn 的返回值, errc>，队列已满时为 errc::blocking_pool_full
+     */
+    template<typename Fn>
+    auto try_blocking(Fn&& fn, blocking_pool& pool = blocking_pool::default_pool()) {
+        return detail::blocking_awaiter<std::decay_t<Fn>, true>(std::forward<Fn>(fn), pool);
+    }
+}
@@ -149,6 +149,9 @@ namespace colite {
             allocator_(other.allocator_),
             target_size_(other.target_size_)
         {
+            if (!*this) {
+                return;
+            }
             if (is_sso()) {
                 auto& sso = target_wrapper_data_.sso;
                 auto& other_sso = other.target_wrapper_data_.sso;
@@ -169,6 +172,9 @@ namespace colite {
             allocator_(std::exchange(other.allocator_, {})),
             target_size_(std::exchange(other.target_size_, 0))
         {
+            if (!*this) {
+                return;
+            }
             if (is_sso()) {
                 auto& sso = target_wrapper_data_.sso;
                 auto& other_sso = other.target_wrapper_data_.sso;
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <stdexcept>
+#include "colite/allocator.h"
+#include "colite/spin_lock.h"
+
+namespace colite {
+    class base_coroutine_state;
+
+    /**
+     * @brief 协程因取消令牌被取消时，在其 co_await 处抛出；等待一个已被取消的协程时也抛出
+     */
+    class operation_canceled: public std::runtime_error {
+    public:
+        operation_canceled(): std::runtime_error("colite: the operation was canceled.") {  }
+        explicit operation_canceled(const char *message): std::runtime_error(message) {  }
+    };
+
+    // 取消令牌的共享状态，登记所有持有该令牌的协程
+    class cancellation_state {
+    public:
+        [[nodiscard]]
+        auto is_cancellation_requested() const -> bool {
+            return canceled_.load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief 登记持有该令牌的协程，由 base_coroutine_state 调用
+         */
+        void attach(base_coroutine_state *state);
+
+        /**
+         * @brief 注销协程，由 base_coroutine_state 在析构时调用
+         */
+        void detach(base_coroutine_state *state);
+
+        /**
+         * @brief 标记为已取消，并取消所有已登记且已启动的协程：已挂起的协程立即被销毁，其任务与定时器被删除；
+         *        正在运行的协程在其下一个挂起点被销毁，或在下一个 co_await 处观察到取消。可在任意线程调用
+         */
+        void cancel();
+
+    private:
+        std::atomic<bool> canceled_ = false;
+        colite::port::spin_lock lock_ {};
+        // 已登记协程的侵入式链表
+        base_coroutine_state *head_ = nullptr;
+    };
+
+    /**
+     * @brief 取消令牌，可复制。绑定到协程之后，该协程等待的子协程自动继承同一个令牌
+     */
+    class cancellation_token {
+        friend class cancellation_source;
+    public:
+        cancellation_token() = default;
+
+        [[nodiscard]]
+        explicit operator bool() const { return state_ != nullptr; }
+
+        /**
+         * @brief 是否已请求取消
+         * @return
+         */
+        [[nodiscard]]
+        auto is_cancellation_requested() const -> bool {
+            return state_ && state_->is_cancellation_requested();
+        }
+
+        [[nodiscard]]
+        auto get_state() const -> const std::shared_ptr<cancellation_state>& {
+            return state_;
+        }
+
+    private:
+        explicit cancellation_token(std::shared_ptr<cancellation_state> state): state_(std::move(state)) {  }
+
+        std::shared_ptr<cancellation_state> state_ {};
+    };
+
+    /**
+     * @brief 取消源：`colite::cancellation_source source; d.launch(handle(request).with_cancellation(source.token()));`
+     *        调用 cancel() 取消所有持有其令牌的协程
+     */
+    class cancellation_source {
+    public:
+        cancellation_source():
+            state_(std::allocate_shared<cancellation_state, colite::allocator::allocator<std::byte>>({}))
+        {
+        }
+
+        [[nodiscard]]
+        auto token() const -> cancellation_token {
+            return cancellation_token { state_ };
+        }
+
+        void cancel() {
+            state_->cancel();
+        }
+
+        [[nodiscard]]
+        auto is_cancellation_requested() const -> bool {
+            return state_->is_cancellation_requested();
+        }
+
+    private:
+        std::shared_ptr<cancellation_state> state_;
+    };
+}
@@ -2,6 +2,16 @@
 
 #include "colite/callable.h"
 #include "colite/suspend.h"
+#include "colite/basic_dispatcher.h"
+#include "colite/interval.h"
+#include "colite/blocking.h"
+#include "colite/shared_suspend.h"
+#include "colite/task_group.h"
+#include "colite/timeout.h"
+#include "colite/expected.h"
+#include "colite/propagate.h"
+#include "colite/cancellation.h"
+#include "colite/registry.h"
 #include "colite/port.h"
 
 namespace colite {
@@ -1,15 +1,125 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <condition_variable>
 #include <coroutine>
+#include <cstdio>
+#include <memory>
 #include <mutex>
+#include <stdexcept>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 #include "colite/callable.h"
 #include "colite/port.h"
+#include "colite/spin_lock.h"
 #include "colite/allocator.h"
 #include "colite/traits.h"
+#include "colite/registry.h"
 #include "colite/state.h"
+#include "colite/expected.h"
 
 namespace colite {
+    class interval;
+
+    class dispatcher;
+
+    class task_group;
+
+    class switch_to;
+
+    template<typename T>
+    class shared_suspend;
+
+    namespace detail {
+        template<typename T>
+        class timeout_awaiter;
+    }
+
+    /**
+     * @brief 调度器的队列已满，且过载策略为 REJECT 时，由 launch 与 post 抛出
+     */
+    class queue_full: public std::runtime_error {
+    public:
+        queue_full(): std::runtime_error("colite: the dispatcher queue is full.") {  }
+    };
+
+    // 不抛出异常的接口（try_launch、try_post、try_blocking）返回的错误
+    enum class errc {
+        // 调度器的队列已满，且过载策略为 REJECT
+        queue_full,
+        // 阻塞任务线程池的队列已满
+        blocking_pool_full
+    };
+
+    // 队列已满时对新任务（launch 与 post）的处理策略。恢复协程、被等待的子协程、with_timeout 的定时器等库的内部任务不受容量限制
+    enum class overload_policy {
+        // 阻塞调用线程直到有空位。在协程中调用时不阻塞线程：新任务被接纳，发起调用的协程在其下一个挂起点之后暂停，
+        // 直到有空位才被恢复；在该调度器的普通任务中调用时无法阻塞，超出上限放行
+        BLOCK,
+        // 抛出 colite::queue_full
+        REJECT,
+        // 丢弃同一优先级中最早的待执行任务，将其从队列中删除；被丢弃的协程被取消
+        SHED_OLDEST,
+        // 丢弃不高于新任务优先级的最低优先级中最早的待执行任务
+        SHED_LOWEST
+    };
+
+    // 调度器的容量限制，只计入尚未开始执行的新任务，0 表示不限制
+    struct queue_limits {
+        size_t max_jobs = 0;
+        std::array<size_t, priority_count> max_jobs_per_priority {};
+        overload_policy policy = overload_policy::REJECT;
+    };
+
+    // 队列已满事件的计数
+    struct queue_stats {
+        // 新任务到达时队列已满的次数
+        size_t full = 0;
+        size_t rejected = 0;
+        size_t shed = 0;
+        // 调用线程或发起调用的协程因 BLOCK 策略被阻塞的次数
+        size_t blocked = 0;
+    };
+
+    namespace detail {
+        // 新任务的准入凭据，由任务持有，任务开始执行或被删除时归还名额
+        class admission: public std::enable_shared_from_this<admission> {
+            friend class colite::dispatcher;
+        public:
+            admission(dispatcher *owner, colite::priority priority, std::weak_ptr<base_coroutine_state> coroutine):
+                owner_(owner),
+                priority_(priority),
+                coroutine_(std::move(coroutine))
+            {  }
+            ~admission();
+
+            admission(const admission&) = delete;
+            admission& operator=(const admission&) = delete;
+
+            /**
+             * @brief 是否已被丢弃。被丢弃的任务随即从队列中删除，该标记只用于删除之前已被取出的任务
+             * @return
+             */
+            [[nodiscard]]
+            auto is_shed() const -> bool {
+                return shed_.load(std::memory_order_acquire);
+            }
+
+        private:
+            dispatcher *const owner_;
+            const colite::priority priority_;
+            // launch 启动的协程，被丢弃时取消该协程；为空时为 post 投递的任务，以该凭据的地址为任务 id 删除
+            const std::weak_ptr<base_coroutine_state> coroutine_;
+            std::atomic<bool> shed_ = false;
+            // 同一优先级的待执行任务按到达顺序链接，由调度器的 admission_lock_ 保护
+            admission *prev_ = nullptr;
+            admission *next_ = nullptr;
+            bool linked_ = false;
+        };
+    }
+
     // 调度器基类
     class dispatcher {
         using byte_allocator = colite::allocator::allocator<std::byte>;
@@ -17,59 +127,755 @@ namespace colite {
         template<typename T>
         friend class colite::suspend;
 
+        friend class colite::interval;
+
+        friend class colite::task_group;
+
+        friend class colite::switch_to;
+
+        template<typename T>
+        friend class colite::shared_suspend;
+
+        template<typename T>
+        friend class detail::timeout_awaiter;
+
+        template<typename R>
+        friend class detail::propagate_awaiter;
+
+        template<typename C, typename R>
+        friend class detail::promise_type;
+
     public:
         explicit dispatcher() = default;
         virtual ~dispatcher() = default;
 
-        auto sleep(colite::port::time_duration time) -> colite::suspend<>;
+        auto sleep(
+            colite::port::time_duration time,
+            colite::priority priority = colite::priority::NORMAL
+        ) -> colite::suspend<>;
 
         template<typename Coro>
             requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
         auto launch(
             Coro&& coroutine,
             colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> decltype(auto) {
+            return launch_on(*this, std::forward<Coro>(coroutine), duration);
+        }
+
+        /**
+         * @brief 以指定的优先级启动协程，该协程等待的子协程继承该优先级
+         * @param coroutine 协程
+         * @param priority 优先级
+         * @param duration 延迟时间
+         */
+        template<typename Coro>
+            requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
+        auto launch(
+            Coro&& coroutine,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> decltype(auto) {
+            colite_assert(coroutine.state_);
+            coroutine.state_->set_priority(priority);
+            return launch(std::forward<Coro>(coroutine), duration);
+        }
+
+        /**
+         * @brief 向调度器投递一个普通任务，可在任意线程调用（例如跨分片传递消息）
+         * @param callable 任务
+         * @param duration 延迟时间
+         */
+        void post(
+            colite::callable<void()> callable,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) {
+            post_on(*this, std::move(callable), colite::priority::NORMAL, duration);
+        }
+
+        /**
+         * @brief 以指定的优先级投递一个普通任务，可在任意线程调用
+         * @param callable 任务
+         * @param priority 优先级
+         * @param duration 延迟时间
+         */
+        void post(
+            colite::callable<void()> callable,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) {
+            post_on(*this, std::move(callable), priority, duration);
+        }
+
+        /**
+         * @brief 与 launch 相同，但队列已满且过载策略为 REJECT 时不抛出异常，而是返回 errc::queue_full，协程保持未启动。
+         *        关闭异常（COLITE_NO_EXCEPTIONS）时应使用该函数，launch 在这种情况下只能终止程序
+         * @param coroutine 协程
+         * @param duration 延迟时间
+         * @return 已启动的协程或错误
+         */
+        template<typename T>
+        auto try_launch(
+            colite::suspend<T>&& coroutine,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> colite::expected<colite::suspend<T>, errc> {
+            return try_launch_on(*this, std::move(coroutine), duration);
+        }
+
+        template<typename T>
+        auto try_launch(
+            colite::suspend<T>&& coroutine,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> colite::expected<colite::suspend<T>, errc> {
+            colite_assert(coroutine.state_);
+            coroutine.state_->set_priority(priority);
+            return try_launch_on(*this, std::move(coroutine), duration);
+        }
+
+        /**
+         * @brief 与 post 相同，但队列已满且过载策略为 REJECT 时不抛出异常，而是返回 errc::queue_full，任务不入队
+         * @param callable 任务
+         * @param duration 延迟时间
+         */
+        auto try_post(
+            colite::callable<void()> callable,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> colite::expected<void, errc> {
+            return try_post_on(*this, std::move(callable), colite::priority::NORMAL, duration);
+        }
+
+        auto try_post(
+            colite::callable<void()> callable,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> colite::expected<void, errc> {
+            return try_post_on(*this, std::move(callable), priority, duration);
+        }
+
+        /**
+         * @brief 设置新任务的容量限制与过载策略，默认不限制
+         * @param limits 容量限制
+         */
+        void set_queue_limits(const queue_limits& limits);
+
+        [[nodiscard]]
+        auto get_queue_limits() -> queue_limits;
+
+        /**
+         * @brief 获取队列已满事件的计数
+         * @return
+         */
+        [[nodiscard]]
+        auto get_queue_stats() const -> queue_stats;
+
+        /**
+         * @brief 获取已被接纳、尚未开始执行的新任务数（仅在设置了容量限制时统计）
+         * @param priority 优先级
+         * @return
+         */
+        [[nodiscard]]
+        auto pending_jobs(colite::priority priority) -> size_t;
+
+        // 等待指定优先级有空位
+        class capacity_awaiter {
+        public:
+            capacity_awaiter(dispatcher& owner, colite::priority priority): owner_(owner), priority_(priority) {  }
+
+            [[nodiscard]]
+            auto await_ready() const -> bool {
+                std::lock_guard locker { owner_.admission_lock_ };
+                return owner_.has_capacity(priority_);
+            }
+
+            template<typename Promise>
+            auto await_suspend(std::coroutine_handle<Promise> handle) -> bool {
+                std::shared_ptr<base_coroutine_state> state = handle.promise().get_state();
+                auto& owner = owner_;
+                std::lock_guard locker { owner.admission_lock_ };
+                if (owner.has_capacity(priority_)) {
+                    return false;
+                }
+                owner.capacity_waiters_[static_cast<size_t>(priority_)].emplace_back(state);
+                // 挂起之后当前对象可能随协程帧一起被销毁，之后只使用局部变量
+                state->suspended("capacity", &owner);
+                return true;
+            }
+
+            void await_resume() const noexcept {  }
+
+        private:
+            dispatcher& owner_;
+            colite::priority priority_;
+        };
+
+        /**
+         * @brief 挂起当前协程，直到指定优先级有空位：`co_await d.wait_for_capacity(); d.launch(work());`
+         *        没有设置容量限制时立即返回。空位不会被预留，并发的生产者仍可能遇到队列已满
+         * @param priority 优先级
+         */
+        auto wait_for_capacity(colite::priority priority = colite::priority::NORMAL) -> capacity_awaiter {
+            return capacity_awaiter { *this, priority };
+        }
+
+        /**
+         * @brief 开启或关闭存活协程的注册表。开启之后在该调度器上启动的协程被登记，直到其状态析构；
+         *        关闭不会注销已登记的协程。调度器须比登记在其注册表中的协程状态存活得久
+         * @param enable 是否开启
+         */
+        void enable_registry(bool enable = true) {
+            registry_enabled_.store(enable, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        auto get_registry() -> coroutine_registry& {
+            return registry_;
+        }
+
+        /**
+         * @brief 输出该调度器上存活协程的状态、协程帧大小、创建位置、等待的对象与挂起时长，可在任意线程调用
+         * @param out 输出的文件
+         */
+        void dump_coroutines(std::FILE *out = stderr) {
+            registry_.dump(out);
+        }
+
+        /**
+         * @brief 在协程所属的调度器上安排恢复该协程，可在任意线程调用。
+         *        用于自定义的等待体：在 await_suspend 中调用 state->suspended() 之后，由完成方调用本函数
+         * @param state 协程状态
+         * @param delay 延迟时间
+         */
+        static void schedule_resume(
+            const std::shared_ptr<base_coroutine_state>& state,
+            colite::port::time_duration delay = colite::port::time_duration(0)
+        );
+
+        /**
+         * @brief 请求取消协程，可在任意线程调用。若协程已挂起则立即销毁，若正在运行则推迟到其下一个挂起点；
+         *        协程的等待者随后被恢复，并在 co_await 处观察到取消
+         * @param state 协程状态
+         */
+        static void request_cancel(base_coroutine_state& state);
+
+        /**
+         * @brief 设置协程的时间片，供 colite::should_yield() 判断
+         * @param time_slice 时间片
+         */
+        void set_time_slice(colite::port::time_duration time_slice) {
+            time_slice_ = time_slice;
+        }
+
+        [[nodiscard]]
+        auto get_time_slice() const -> colite::port::time_duration {
+            return time_slice_;
+        }
+
+        /**
+         * @brief 当前线程上运行的协程是否已用完其调度器的时间片。
+         *        时间片从协程本次被恢复后第一次调用本函数时开始计算，不在协程中调用时总是返回 false
+         * @return
+         */
+        static auto should_yield() -> bool;
+
+        /**
+         * @brief 当前线程上运行的协程绑定的取消令牌是否已请求取消，不在协程中调用时总是返回 false
+         * @return
+         */
+        static auto is_cancellation_requested() -> bool;
+
+        /**
+         * @brief 调度器的时钟，延迟任务的就绪时间与时间片都以它计算。默认为 colite::port::current_time()，仿真调度器返回其虚拟时间
+         * @return
+         */
+        [[nodiscard]]
+        virtual auto clock() const -> colite::port::time_point {
+            return colite::port::current_time();
+        }
+
+        /**
+         * @brief 当前线程上运行的调度器的时钟，不在调度器中调用时为 colite::port::current_time()
+         * @return
+         */
+        static auto current_clock() -> colite::port::time_point;
+
+    protected:
+        std::mutex lock_{};
+
+        // 协程的时间片
+        colite::port::time_duration time_slice_ = std::chrono::milliseconds(1);
+
+        /**
+         * @brief 取消所有与当前协程关联的任务，并从协程列表中删除该协程
+         * @param handle 协程句柄
+         */
+        void cancel(std::coroutine_handle<> handle);
+
+        /**
+         * @brief 在当前线程上恢复协程。若协程已被取消、已结束或正在其他线程上运行，则无操作；
+         *        若协程在运行期间被请求取消，则在其挂起后完成取消
+         * @param state 协程状态
+         */
+        static void resume(const std::shared_ptr<base_coroutine_state>& state);
+
+        /**
+         * @brief 完成取消：删除协程在调度器上的任务并销毁协程帧。调用者必须已将状态切换为 CANCELED
+         * @param state 协程状态
+         */
+        static void destroy_canceled(base_coroutine_state& state);
+
+        /**
+         * @brief 协程结束或被取消之后交给等待者：由等待体设置的交接函数处理，没有设置时恢复等待者
+         * @param state 已结束或已取消的协程状态
+         */
+        static void complete_awaiter(base_coroutine_state& state);
+
+        /**
+         * @brief 启动库内部的协程：被等待的子协程、shared_suspend 的驱动协程、task_group 的子协程、sleep 等。
+         *        不经过容量限制：其等待者已经挂起或即将挂起，拒绝或丢弃它们会使等待者无法恢复
+         * @param coroutine 协程
+         * @param duration 延迟时间
+         */
+        template<typename Coro>
+            requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
+        auto launch_internal(
+            Coro&& coroutine,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> decltype(auto) {
+            return start_on(*this, std::forward<Coro>(coroutine), duration, nullptr);
+        }
+
+        template<typename Coro>
+            requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
+        auto launch_internal(
+            Coro&& coroutine,
+            colite::priority priority,
+            colite::port::time_duration duration = colite::port::time_duration(0)
+        ) -> decltype(auto) {
+            colite_assert(coroutine.state_);
+            coroutine.state_->set_priority(priority);
+            return launch_internal(std::forward<Coro>(coroutine), duration);
+        }
+
+        /**
+         * @brief launch 的实现。Self 为具体调度器类型时，启动与完成任务的入队在编译期确定，不经过虚函数
+         * @param self 调度器
+         * @param coroutine 协程
+         * @param duration 延迟时间
+         */
+        template<typename Self, typename Coro>
+        static auto launch_on(
+            Self& self,
+            Coro&& coroutine,
+            colite::port::time_duration duration
+        ) -> decltype(auto) {
+            colite_assert(coroutine.state_);
+            auto ticket = self.admit(coroutine.state_->get_priority(), coroutine.state_);
+            if (!ticket) {
+                // 队列已满且策略为 REJECT，协程保持未启动
+                colite_throw(queue_full());
+            }
+            return start_on(self, std::forward<Coro>(coroutine), duration, std::move(*ticket));
+        }
+
+        /**
+         * @brief try_launch 的实现，Self 的含义同 launch_on
+         */
+        template<typename Self, typename T>
+        static auto try_launch_on(
+            Self& self,
+            colite::suspend<T>&& coroutine,
+            colite::port::time_duration duration
+        ) -> colite::expected<colite::suspend<T>, errc> {
+            colite_assert(coroutine.state_);
+            auto ticket = self.admit(coroutine.state_->get_priority(), coroutine.state_);
+            if (!ticket) {
+                return colite::unexpected(ticket.error());
+            }
+            return start_on(self, std::move(coroutine), duration, std::move(*ticket));
+        }
+
+        /**
+         * @brief 启动协程并将其恢复任务入队
+         * @param ticket 准入凭据，不经过准入时为空
+         */
+        template<typename Self, typename Coro>
+        static auto start_on(
+            Self& self,
+            Coro&& coroutine,
+            colite::port::time_duration duration,
+            std::shared_ptr<detail::admission> ticket
         ) -> decltype(auto) {
             std::coroutine_handle<> handle = coroutine.get_coroutine_handle();
             colite_assert(handle);
-            coroutine.state_->set_dispatcher(this);
-            coroutine.state_->set_status(coroutine_status::STARTED);
+            std::shared_ptr<base_coroutine_state> state = coroutine.state_;
+            state->set_dispatcher(&self);
+            if (self.registry_enabled_.load(std::memory_order_relaxed)) {
+                self.registry_.attach(state.get());
+            }
+            // 在启动之前已被取消（例如刚被接纳就被其他新任务挤掉）时不再入队
+            if (!state->transition(coroutine_status::CREATED, coroutine_status::STARTED)) {
+                return std::forward<Coro>(coroutine);
+            }
+            // 没有可以丢弃的任务时新任务本身被丢弃：直接取消，不入队
+            if (ticket && ticket->is_shed()) {
+                request_cancel(*state);
+                return std::forward<Coro>(coroutine);
+            }
 
             // 前往目标调度器上回复该协程
-            dispatch(handle.address(), duration, [handle, state = coroutine.state_, this] {
-                handle.resume();
-                // 当当前协程执行完毕之后，判断后续任务（是否要恢复等待者的协程），并销毁当前协程
-                dispatch(handle.address(), colite::port::time_duration(0),
-                    [handle, state, this] {
-                        if (state->is_awaited()) {
-                            auto [awaiter_handle, awaiter_dispatcher] = state->awaiter();
-                            awaiter_dispatcher->dispatch(handle.address(), colite::port::time_duration(0),
-                                [handle, awaiter_handle, this] {
-                                    awaiter_handle.resume();
-                                }
-                            );
-                        }
-                    },
-                    [=] {
-                        auto status = state->get_status();
-                        return status == coroutine_status::CANCELED || status == coroutine_status::FINISHED;
+            self.enqueue(handle.address(), duration, state->get_priority(), [state, target = &self, ticket = std::move(ticket)] {
+                if (ticket) {
+                    // 开始执行即归还名额，之后不会再被选为丢弃对象；在此之前被丢弃、未能从队列中删除的协程，在这里取消
+                    target->release(*ticket);
+                    if (ticket->is_shed()) {
+                        request_cancel(*state);
+                        return;
                     }
-                );
+                }
+                resume(state);
+                // 当当前协程执行完毕之后，判断后续任务（是否要恢复等待者的协程），并销毁当前协程
+                register_completion(*target, state, false);
             });
 
             return std::forward<Coro>(coroutine);
         }
 
-    protected:
-        std::mutex lock_{};
+        /**
+         * @brief 登记完成任务：协程结束或被取消之后恢复等待者。完成任务须与协程位于同一个调度器上，
+         *        destroy_canceled 才能将其删除，事件循环也才会在协程结束之后及时执行它
+         * @param self 协程当前所在的调度器
+         * @param state 协程状态
+         * @param migrate 为 false 时（start_on 首次恢复之后）若已由 switch_to 登记则不再登记；
+         *        为 true 时（switch_to）从之前的调度器上删除已登记的完成任务，改登记到 self
+         */
+        template<typename Self>
+        static void register_completion(Self& self, const std::shared_ptr<base_coroutine_state>& state, bool migrate) {
+            auto id = state->get_handle().address();
+            state->lock_completion();
+            auto previous = state->exchange_completion_dispatcher(&self);
+            if (previous && !migrate) {
+                // 协程在首次恢复期间已迁移，完成任务已在目标调度器上
+                state->exchange_completion_dispatcher(previous);
+                state->unlock_completion();
+                return;
+            }
+            if (previous) {
+                // 协程正在运行，之前的调度器上以其句柄为 id 的任务只有完成任务
+                previous->cancel_jobs(id);
+            }
+            self.enqueue(id, colite::port::time_duration(0), state->get_priority(),
+                [state] {
+                    complete_awaiter(*state);
+                },
+                [state] {
+                    auto status = state->get_status();
+                    return status == coroutine_status::CANCELED || status == coroutine_status::FINISHED;
+                }
+            );
+            state->unlock_completion();
+        }
 
         /**
-         * @brief 取消所有与当前协程关联的任务，并从协程列表中删除该协程
-         * @param handle 协程句柄
+         * @brief post 的实现，Self 的含义同 launch_on
          */
-        void cancel(std::coroutine_handle<> handle);
+        template<typename Self>
+        static void post_on(
+            Self& self,
+            colite::callable<void()> callable,
+            colite::priority priority,
+            colite::port::time_duration duration
+        ) {
+            if (!try_post_on(self, std::move(callable), priority, duration)) {
+                colite_throw(queue_full());
+            }
+        }
+
+        /**
+         * @brief try_post 的实现，Self 的含义同 launch_on
+         */
+        template<typename Self>
+        static auto try_post_on(
+            Self& self,
+            colite::callable<void()> callable,
+            colite::priority priority,
+            colite::port::time_duration duration
+        ) -> colite::expected<void, errc> {
+            auto admitted = self.admit(priority, {});
+            if (!admitted) {
+                return colite::unexpected(admitted.error());
+            }
+            auto ticket = std::move(*admitted);
+            if (!ticket) {
+                self.enqueue(nullptr, duration, priority, std::move(callable));
+                return {};
+            }
+            // 没有可以丢弃的任务时新任务本身被丢弃，不入队
+            if (ticket->is_shed()) {
+                return {};
+            }
+            // 以凭据的地址为任务 id，被丢弃时按该 id 从队列中删除
+            auto id = static_cast<void*>(ticket.get());
+            self.enqueue(id, duration, priority, [ticket = std::move(ticket), target = &self, callable = std::move(callable)] {
+                target->release(*ticket);
+                if (!ticket->is_shed()) {
+                    callable();
+                }
+            });
+            return {};
+        }
+
+        /**
+         * @brief 为新任务办理准入：队列已满时按过载策略阻塞、拒绝或丢弃其他任务
+         * @param priority 新任务的优先级
+         * @param coroutine launch 启动的协程，post 投递的任务为空
+         * @return 准入凭据，须由任务持有，没有设置容量限制时为空；被 REJECT 策略拒绝时返回 errc::queue_full
+         */
+        auto admit(colite::priority priority, std::weak_ptr<base_coroutine_state> coroutine) -> colite::expected<std::shared_ptr<detail::admission>, errc>;
+
+        // 经由虚函数入队，basic_dispatcher 以同名函数覆盖为静态分派
+        void enqueue(void *id, colite::port::time_duration time, colite::priority priority, colite::callable<void()> callable) {
+            dispatch(id, time, priority, std::move(callable));
+        }
+
+        void enqueue(void *id, colite::port::time_duration time, colite::priority priority, colite::callable<void()> callable, colite::callable<bool()> predicate) {
+            dispatch(id, time, priority, std::move(callable), std::move(predicate));
+        }
+
+        // 不做任何事的协程，用于 sleep
+        static auto nop_coroutine() -> colite::suspend<>;
+
+        /**
+         * @brief 安排恢复协程的任务。默认包装为普通任务；调度器可以重写为直接将协程内嵌的恢复节点入队，
+         *        入队的节点以协程句柄的地址为 id，须能被 cancel_jobs 删除
+         * @param state 协程状态
+         * @param time 延迟时间
+         */
+        virtual void dispatch_resume(const std::shared_ptr<base_coroutine_state>& state, colite::port::time_duration time);
+
+        /**
+         * @brief 取得协程内嵌的恢复节点并填写任务信息
+         * @return 若该节点已在队列中则返回空，调用者应改用普通任务
+         */
+        static auto acquire_resume_node(
+            const std::shared_ptr<base_coroutine_state>& state,
+            colite::port::time_duration time
+        ) -> detail::resume_node*;
 
-        virtual void dispatch(void *id, colite::port::time_duration time, colite::callable<void()> callable) = 0;
-        virtual void dispatch(void *id, colite::port::time_duration time, colite::callable<void()> callable, colite::callable<bool()> predicate) = 0;
+        /**
+         * @brief 执行已出队的恢复节点：释放节点并恢复协程
+         */
+        static void run_resume_node(detail::resume_node *node);
+
+        /**
+         * @brief 释放已出队但不再执行的恢复节点（例如任务被删除）
+         */
+        static void release_resume_node(detail::resume_node *node);
+
+        /**
+         * @brief 调度器在当前线程上执行其任务期间存在，使 admit 能识别出在本调度器的任务中发起的调用（见 overload_policy::BLOCK）。
+         *        调度器的运行循环在执行普通任务与恢复节点时都应构造该对象
+         */
+        class job_scope;
+
+        virtual void dispatch(void *id, colite::port::time_duration time, colite::priority priority, colite::callable<void()> callable) = 0;
+        virtual void dispatch(void *id, colite::port::time_duration time, colite::priority priority, colite::callable<void()> callable, colite::callable<bool()> predicate) = 0;
         virtual void cancel_jobs(void *id) = 0;
+
+        /**
+         * @brief 投递可作废的延迟任务：tombstone 被置位之后任务作废，执行时什么也不做，也不必经由 cancel_jobs 按 id 查找删除。
+         *        tombstone 须在任务析构之前保持有效。默认实现在到期时才跳过；调度器可以重写为在扫描队列时提前丢弃已作废的任务
+         * @param tombstone 作废标记
+         */
+        virtual void dispatch_revocable(
+            void *id,
+            colite::port::time_duration time,
+            colite::priority priority,
+            colite::callable<void()> callable,
+            const std::atomic<bool> *tombstone
+        ) {
+            dispatch(id, time, priority, [callable = std::move(callable), tombstone] {
+                if (!tombstone->load(std::memory_order_acquire)) {
+                    callable();
+                }
+            });
+        }
+
+        /**
+         * @brief 协程在该调度器上结束时调用，此时状态已切换为 FINISHED，其完成任务的条件随之成立。
+         *        调度器可以重写它来得知完成任务已就绪，而不必定期检查完成任务的条件
+         */
+        virtual void coroutine_finished() noexcept {  }
+
+    private:
+        friend class detail::admission;
+
+        // 存活协程的注册表，默认关闭
+        coroutine_registry registry_ {};
+        std::atomic<bool> registry_enabled_ = false;
+
+        // 容量限制与准入记录，由 admission_lock_ 保护
+        colite::port::spin_lock admission_lock_ {};
+        std::atomic<bool> bounded_ = false;
+        queue_limits limits_ {};
+        size_t pending_total_ = 0;
+        std::array<size_t, priority_count> pending_ {};
+        // 每个优先级中待执行的新任务，按到达顺序
+        std::array<detail::admission*, priority_count> admitted_head_ {};
+        std::array<detail::admission*, priority_count> admitted_tail_ {};
+        std::array<std::vector<std::shared_ptr<base_coroutine_state>>, priority_count> capacity_waiters_ {};
+        // 因 BLOCK 策略阻塞的线程在此等待名额归还
+        std::condition_variable_any capacity_released_ {};
+        size_t blocked_threads_ = 0;
+
+        struct atomic_queue_stats {
+            std::atomic<size_t> full = 0;
+            std::atomic<size_t> rejected = 0;
+            std::atomic<size_t> shed = 0;
+            std::atomic<size_t> blocked = 0;
+        } stats_ {};
+
+        // 指定优先级是否还有空位，须持有 admission_lock_
+        auto has_capacity(colite::priority priority) const -> bool;
+
+        // 选出被丢弃的任务，须持有 admission_lock_
+        auto pick_victim(colite::priority priority) -> detail::admission*;
+
+        // 从准入记录中移除并归还名额，须持有 admission_lock_
+        void unlink(detail::admission& admission);
+
+        // 任务开始执行或被删除，归还名额并唤醒一个等待空位的协程
+        void release(detail::admission& admission);
+
+        /**
+         * @brief 恢复协程之前检查其容量闸门（见 overload_policy::BLOCK），仍没有空位时将协程登记为等待空位
+         * @return 协程是否被暂停，暂停的协程在有空位时再次被安排恢复
+         */
+        static auto hold_for_capacity(const std::shared_ptr<base_coroutine_state>& state) -> bool;
+
+        // 当前线程上正在运行的协程及其时间片
+        struct running_coroutine {
+            base_coroutine_state *state_ = nullptr;
+            const dispatcher *dispatcher_ = nullptr;
+            colite::port::time_point slice_start_ = colite::port::time_point::max();
+        };
+
+        static thread_local running_coroutine current_;
+    };
+
+    class dispatcher::job_scope {
+    public:
+        explicit job_scope(const dispatcher& owner):
+            previous_(std::exchange(current_, running_coroutine { .dispatcher_ = &owner }))
+        {  }
+
+        ~job_scope() {
+            current_ = previous_;
+        }
+
+        job_scope(const job_scope&) = delete;
+        job_scope& operator=(const job_scope&) = delete;
+
+    private:
+        running_coroutine previous_;
+    };
+
+    /**
+     * @brief 将当前协程迁移到目标调度器上继续执行：`co_await colite::switch_to(target);`
+     */
+    class switch_to {
+    public:
+        explicit switch_to(dispatcher& target): target_(target) {  }
+
+        [[nodiscard]]
+        auto await_ready() const noexcept -> bool { return false; }
+
+        template<typename Promise>
+        auto await_suspend(std::coroutine_handle<Promise> handle) -> bool {
+            std::shared_ptr<base_coroutine_state> state = handle.promise().get_state();
+            auto target = &target_;
+            if (state->get_dispatcher() == target) {
+                return false;
+            }
+            // 完成任务随协程一起迁移，协程在目标调度器上结束或被取消时由目标调度器处理
+            dispatcher::register_completion(*target, state, true);
+            state->set_dispatcher(target);
+            state->suspended("switch_to", target);
+            dispatcher::schedule_resume(state);
+            return true;
+        }
+
+        void await_resume() const noexcept {  }
+
+    private:
+        dispatcher& target_;
+    };
+
+    /**
+     * @brief 让出调度器：将当前协程重新排入其调度器的队尾，让其他就绪的任务先执行：`co_await colite::yield();`
+     */
+    class yield {
+    public:
+        [[nodiscard]]
+        auto await_ready() const noexcept -> bool { return false; }
+
+        template<typename Promise>
+        void await_suspend(std::coroutine_handle<Promise> handle) {
+            std::shared_ptr<base_coroutine_state> state = handle.promise().get_state();
+            state->suspended("yield");
+            dispatcher::schedule_resume(state);
+        }
+
+        void await_resume() const noexcept {  }
+    };
+
+    namespace detail {
+        // `co_await 时长`：在当前协程的调度器上直接安排延迟恢复，不经过子协程，到期后只需一次调度
+        class sleep_awaiter {
+        public:
+            explicit sleep_awaiter(colite::port::time_duration delay): delay_(delay) {  }
+
+            [[nodiscard]]
+            auto await_ready() const noexcept -> bool { return false; }
+
+            template<typename Promise>
+            void await_suspend(std::coroutine_handle<Promise> handle) {
+                std::shared_ptr<base_coroutine_state> state = handle.promise().get_state();
+                auto delay = delay_;
+                // 挂起之后当前对象可能随协程帧一起被销毁，之后只使用局部变量
+                state->suspended("sleep");
+                dispatcher::schedule_resume(state, delay);
+            }
+
+            void await_resume() const noexcept {  }
+
+        private:
+            colite::port::time_duration delay_;
+        };
+    }
+
+    /**
+     * @brief 当前协程是否已用完其调度器的时间片，用于长循环中按需让出：`if (colite::should_yield()) { ... }`
+     * @return
+     */
+    inline auto should_yield() -> bool {
+        return dispatcher::should_yield();
+    }
+
+    /**
+     * @brief 当前协程绑定的取消令牌是否已请求取消，用于不经过 co_await 的长循环中检查取消
+     * @return
+     */
+    inline auto is_cancellation_requested() -> bool {
+        return dispatcher::is_cancellation_requested();
+    }
+
+    /**
+     * @brief 仅在时间片用完时让出调度器：`co_await colite::maybe_yield();`
+     */
+    class maybe_yield: public yield {
+    public:
+        [[nodiscard]]
+        auto await_ready() const -> bool { return !dispatcher::should_yield(); }
     };
 }
@@ -0,0 +1,382 @@
+#pragma once
+
+#include <exception>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <version>
+#include "colite/port.h"
+
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202211L
+#include <expected>
+#endif
+
+namespace colite {
+#if defined(__cpp_lib_expected) && __cpp_lib_expected >= 202211L
+    // 标准库提供 std::expected 时直接使用
+    template<typename T, typename E>
+    using expected = std::expected<T, E>;
+
+    template<typename E>
+    using unexpected = std::unexpected<E>;
+
+    template<typename E>
+    using bad_expected_access = std::bad_expected_access<E>;
+#else
+    template<typename E>
+    class unexpected {
+    public:
+        template<typename Err = E>
+            requires (!std::is_same_v<std::remove_cvref_t<Err>, unexpected> && std::is_constructible_v<E, Err&&>)
+        constexpr explicit unexpected(Err&& error): error_(std::forward<Err>(error)) {  }
+
+        [[nodiscard]]
+        constexpr auto error() & noexcept -> E& { return error_; }
+
+        [[nodiscard]]
+        constexpr auto error() const& noexcept -> const E& { return error_; }
+
+        [[nodiscard]]
+        constexpr auto error() && noexcept -> E&& { return std::move(error_); }
+
+    private:
+        E error_;
+    };
+
+    template<typename E>
+    unexpected(E) -> unexpected<E>;
+
+    /**
+     * @brief 访问不含值的 expected 的值时抛出
+     */
+    template<typename E>
+    class bad_expected_access: public std::exception {
+    public:
+        explicit bad_expected_access(E error): error_(std::move(error)) {  }
+
+        [[nodiscard]]
+        auto what() const noexcept -> const char* override {
+            return "colite: bad expected access.";
+        }
+
+        [[nodiscard]]
+        auto error() const& noexcept -> const E& { return error_; }
+
+    private:
+        E error_;
+    };
+
+    /**
+     * @brief std::expected（C++23）的子集，标准库没有提供时使用。
+     *        T 与 E 都可平凡复制时 expected 也可平凡复制，作为协程返回值时与普通的小返回值一样直接复制
+     */
+    template<typename T, typename E>
+    class expected {
+        static constexpr bool trivial_copy = std::is_trivially_copy_constructible_v<T> && std::is_trivially_copy_constructible_v<E>;
+        static constexpr bool trivial_move = std::is_trivially_move_constructible_v<T> && std::is_trivially_move_constructible_v<E>;
+        static constexpr bool trivial_assign = std::is_trivially_copyable_v<T> && std::is_trivially_copyable_v<E>;
+        static constexpr bool trivial_destroy = std::is_trivially_destructible_v<T> && std::is_trivially_destructible_v<E>;
+    public:
+        using value_type = T;
+        using error_type = E;
+        using unexpected_type = colite::unexpected<E>;
+
+        constexpr expected() requires std::is_default_constructible_v<T>: value_(), has_value_(true) {  }
+
+        template<typename U = T>
+            requires (
+                !std::is_same_v<std::remove_cvref_t<U>, expected>
+                && !std::is_same_v<std::remove_cvref_t<U>, std::in_place_t>
+                && std::is_constructible_v<T, U&&>
+            )
+        constexpr explicit(!std::is_convertible_v<U&&, T>) expected(U&& value):
+            value_(std::forward<U>(value)), has_value_(true)
+        {  }
+
+        template<typename G>
+            requires std::is_constructible_v<E, const G&>
+        constexpr explicit(!std::is_convertible_v<const G&, E>) expected(const colite::unexpected<G>& error):
+            error_(error.error()), has_value_(false)
+        {  }
+
+        template<typename G>
+            requires std::is_constructible_v<E, G&&>
+        constexpr explicit(!std::is_convertible_v<G&&, E>) expected(colite::unexpected<G>&& error):
+            error_(std::move(error).error()), has_value_(false)
+        {  }
+
+        template<typename... Args>
+        constexpr explicit expected(std::in_place_t, Args&&... args):
+            value_(std::forward<Args>(args)...), has_value_(true)
+        {  }
+
+        constexpr expected(const expected&) requires trivial_copy = default;
+
+        constexpr expected(const expected& other)
+            requires (!trivial_copy && std::is_copy_constructible_v<T> && std::is_copy_constructible_v<E>):
+            has_value_(other.has_value_)
+        {
+            construct_from(other);
+        }
+
+        constexpr expected(expected&&) requires trivial_move = default;
+
+        constexpr expected(expected&& other)
+            noexcept(std::is_nothrow_move_constructible_v<T> && std::is_nothrow_move_constructible_v<E>)
+            requires (!trivial_move && std::is_move_constructible_v<T> && std::is_move_constructible_v<E>):
+            has_value_(other.has_value_)
+        {
+            construct_from(std::move(other));
+        }
+
+        constexpr auto operator=(const expected&) -> expected& requires trivial_assign = default;
+
+        constexpr auto operator=(const expected& other) -> expected&
+            requires (!trivial_assign && std::is_copy_constructible_v<T> && std::is_copy_constructible_v<E>)
+        {
+            if (this != &other) {
+                destroy();
+                has_value_ = other.has_value_;
+                construct_from(other);
+            }
+            return *this;
+        }
+
+        constexpr auto operator=(expected&&) -> expected& requires trivial_assign = default;
+
+        constexpr auto operator=(expected&& other) -> expected&
+            requires (!trivial_assign && std::is_move_constructible_v<T> && std::is_move_constructible_v<E>)
+        {
+            if (this != &other) {
+                destroy();
+                has_value_ = other.has_value_;
+                construct_from(std::move(other));
+            }
+            return *this;
+        }
+
+        constexpr ~expected() requires trivial_destroy = default;
+
+        constexpr ~expected() requires (!trivial_destroy) {
+            destroy();
+        }
+
+        [[nodiscard]]
+        constexpr auto has_value() const noexcept -> bool { return has_value_; }
+
+        [[nodiscard]]
+        constexpr explicit operator bool() const noexcept { return has_value_; }
+
+        [[nodiscard]]
+        constexpr auto operator*() & noexcept -> T& { colite_assert(has_value_); return value_; }
+
+        [[nodiscard]]
+        constexpr auto operator*() const& noexcept -> const T& { colite_assert(has_value_); return value_; }
+
+        [[nodiscard]]
+        constexpr auto operator*() && noexcept -> T&& { colite_assert(has_value_); return std::move(value_); }
+
+        [[nodiscard]]
+        constexpr auto operator->() noexcept -> T* { colite_assert(has_value_); return std::addressof(value_); }
+
+        [[nodiscard]]
+        constexpr auto operator->() const noexcept -> const T* { colite_assert(has_value_); return std::addressof(value_); }
+
+        [[nodiscard]]
+        constexpr auto value() & -> T& {
+            check_value();
+            return value_;
+        }
+
+        [[nodiscard]]
+        constexpr auto value() const& -> const T& {
+            check_value();
+            return value_;
+        }
+
+        [[nodiscard]]
+        constexpr auto value() && -> T&& {
+            check_value();
+            return std::move(value_);
+        }
+
+        [[nodiscard]]
+        constexpr auto error() & noexcept -> E& { colite_assert(!has_value_); return error_; }
+
+        [[nodiscard]]
+        constexpr auto error() const& noexcept -> const E& { colite_assert(!has_value_); return error_; }
+
+        [[nodiscard]]
+        constexpr auto error() && noexcept -> E&& { colite_assert(!has_value_); return std::move(error_); }
+
+        template<typename U>
+        [[nodiscard]]
+        constexpr auto value_or(U&& other) const& -> T {
+            return has_value_ ? value_ : static_cast<T>(std::forward<U>(other));
+        }
+
+        template<typename U>
+        [[nodiscard]]
+        constexpr auto value_or(U&& other) && -> T {
+            return has_value_ ? std::move(value_) : static_cast<T>(std::forward<U>(other));
+        }
+
+    private:
+        union {
+            T value_;
+            E error_;
+        };
+        bool has_value_;
+
+        constexpr void check_value() const {
+            if (!has_value_) {
+                colite_throw(bad_expected_access<std::decay_t<E>>(error_));
+            }
+        }
+
+        template<typename Other>
+        constexpr void construct_from(Other&& other) {
+            if (has_value_) {
+                std::construct_at(std::addressof(value_), std::forward<Other>(other).value_);
+            } else {
+                std::construct_at(std::addressof(error_), std::forward<Other>(other).error_);
+            }
+        }
+
+        constexpr void destroy() {
+            if (has_value_) {
+                std::destroy_at(std::addressof(value_));
+            } else {
+                std::destroy_at(std::addressof(error_));
+            }
+        }
+    };
+
+    template<typename E>
+    class expected<void, E> {
+    public:
+        using value_type = void;
+        using error_type = E;
+        using unexpected_type = colite::unexpected<E>;
+
+        constexpr expected() noexcept: has_value_(true) {  }
+
+        template<typename G>
+            requires std::is_constructible_v<E, const G&>
+        constexpr explicit(!std::is_convertible_v<const G&, E>) expected(const colite::unexpected<G>& error):
+            error_(error.error()), has_value_(false)
+        {  }
+
+        template<typename G>
+            requires std::is_constructible_v<E, G&&>
+        constexpr explicit(!std::is_convertible_v<G&&, E>) expected(colite::unexpected<G>&& error):
+            error_(std::move(error).error()), has_value_(false)
+        {  }
+
+        constexpr expected(const expected&) requires std::is_trivially_copy_constructible_v<E> = default;
+
+        constexpr expected(const expected& other)
+            requires (!std::is_trivially_copy_constructible_v<E> && std::is_copy_constructible_v<E>):
+            has_value_(other.has_value_)
+        {
+            if (!has_value_) {
+                std::construct_at(std::addressof(error_), other.error_);
+            }
+        }
+
+        constexpr expected(expected&&) requires std::is_trivially_move_constructible_v<E> = default;
+
+        constexpr expected(expected&& other) noexcept(std::is_nothrow_move_constructible_v<E>)
+            requires (!std::is_trivially_move_constructible_v<E> && std::is_move_constructible_v<E>):
+            has_value_(other.has_value_)
+        {
+            if (!has_value_) {
+                std::construct_at(std::addressof(error_), std::move(other.error_));
+            }
+        }
+
+        constexpr auto operator=(const expected&) -> expected& requires std::is_trivially_copyable_v<E> = default;
+
+        constexpr auto operator=(const expected& other) -> expected&
+            requires (!std::is_trivially_copyable_v<E> && std::is_copy_constructible_v<E>)
+        {
+            if (this != &other) {
+                destroy();
+                has_value_ = other.has_value_;
+                if (!has_value_) {
+                    std::construct_at(std::addressof(error_), other.error_);
+                }
+            }
+            return *this;
+        }
+
+        constexpr auto operator=(expected&&) -> expected& requires std::is_trivially_copyable_v<E> = default;
+
+        constexpr auto operator=(expected&& other) -> expected&
+            requires (!std::is_trivially_copyable_v<E> && std::is_move_constructible_v<E>)
+        {
+            if (this != &other) {
+                destroy();
+                has_value_ = other.has_value_;
+                if (!has_value_) {
+                    std::construct_at(std::addressof(error_), std::move(other.error_));
+                }
+            }
+            return *this;
+        }
+
+        constexpr ~expected() requires std::is_trivially_destructible_v<E> = default;
+
+        constexpr ~expected() requires (!std::is_trivially_destructible_v<E>) {
+            destroy();
+        }
+
+        [[nodiscard]]
+        constexpr auto has_value() const noexcept -> bool { return has_value_; }
+
+        [[nodiscard]]
+        constexpr explicit operator bool() const noexcept { return has_value_; }
+
+        constexpr void operator*() const noexcept { colite_assert(has_value_); }
+
+        constexpr void value() const {
+            if (!has_value_) {
+                colite_throw(bad_expected_access<std::decay_t<E>>(error_));
+            }
+        }
+
+        [[nodiscard]]
+        constexpr auto error() & noexcept -> E& { colite_assert(!has_value_); return error_; }
+
+        [[nodiscard]]
+        constexpr auto error() const& noexcept -> const E& { colite_assert(!has_value_); return error_; }
+
+        [[nodiscard]]
+        constexpr auto error() && noexcept -> E&& { colite_assert(!has_value_); return std::move(error_); }
+
+    private:
+        union {
+            E error_;
+        };
+        bool has_value_;
+
+        constexpr void destroy() {
+            if (!has_value_) {
+                std::destroy_at(std::addressof(error_));
+            }
+        }
+    };
+#endif
+
+    namespace traits {
+        /**
+         * @brief 判断类型 T 是否为 colite::expected
+         * @tparam T
+         */
+        template<typename T>
+        constexpr bool is_expected = false;
+
+        template<typename T, typename E>
+        constexpr bool is_expected<colite::expected<T, E>> = true;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <coroutine>
+#include <memory>
+#include "colite/port.h"
+#include "colite/state.h"
+#include "colite/dispatchers.h"
+
+namespace colite {
+    // 错过节拍时的处理策略
+    enum class missed_tick_policy {
+        // 立即补发所有错过的节拍，之后恢复原有节奏
+        BURST,
+        // 立即触发一次，跳过其余错过的节拍，对齐到原有节奏中的下一个节拍
+        SKIP,
+        // 立即触发一次，之后以当前时间为起点重新计时
+        DELAY
+    };
+
+    /**
+     * @brief 固定频率的周期定时器：`colite::interval ticker { 50ms }; while (...) { co_await ticker; }`
+     *        节拍按 起始时间 + n * 周期 计算，不会因为协程被恢复的延迟而累积漂移；
+     *        每次等待复用协程内嵌的恢复节点，不分配任务，也不创建新的协程帧与协程状态；
+     *        等待中的协程被取消时，其节拍随协程的其他任务一并从调度器上删除。
+     *        节拍以当前线程上运行的调度器的时钟计算（见 dispatcher::clock），仿真调度器中为虚拟时间
+     */
+    class interval {
+    public:
+        explicit interval(
+            colite::port::time_duration period,
+            missed_tick_policy policy = missed_tick_policy::BURST
+        ): period_(period),
+           policy_(policy),
+           deadline_(dispatcher::current_clock() + period)
+        {
+            colite_assert(period > colite::port::time_duration(0));
+        }
+
+        interval(const interval&) = delete;
+        interval& operator=(const interval&) = delete;
+
+        /**
+         * @brief 获取下一个节拍的时间点
+         * @return
+         */
+        [[nodiscard]]
+        auto next_deadline() const -> colite::port::time_point { return deadline_; }
+
+        /**
+         * @brief 重新以当前时间为起点计时
+         */
+        void reset() {
+            deadline_ = dispatcher::current_clock() + period_;
+        }
+
+        class awaiter {
+        public:
+            explicit awaiter(interval& owner): owner_(owner) {  }
+
+            [[nodiscard]]
+            auto await_ready() -> bool {
+                return owner_.try_tick(dispatcher::current_clock());
+            }
+
+            template<typename Promise>
+            void await_suspend(std::coroutine_handle<Promise> handle) {
+                std::shared_ptr<base_coroutine_state> state = handle.promise().get_state();
+                owner_.arm(std::move(state));
+            }
+
+            void await_resume() const noexcept {  }
+
+        private:
+            interval& owner_;
+        };
+
+        /**
+         * @brief 等待下一个节拍
+         */
+        auto operator co_await() -> awaiter {
+            return awaiter { *this };
+        }
+
+    private:
+        colite::port::time_duration period_;
+        missed_tick_policy policy_;
+        colite::port::time_point deadline_;
+
+        /**
+         * @brief 若已到达节拍则立即触发，并按策略安排下一个节拍
+         * @param now 当前时间
+         * @return 是否已到达节拍
+         */
+        auto try_tick(colite::port::time_point now) -> bool {
+            if (now < deadline_) {
+                return false;
+            }
+            switch (policy_) {
+                case missed_tick_policy::BURST:
+                    deadline_ += period_;
+                    break;
+                case missed_tick_policy::SKIP:
+                    deadline_ += period_ * ((now - deadline_) / period_ + 1);
+                    break;
+                case missed_tick_policy::DELAY:
+                    deadline_ = now + period_;
+                    break;
+            }
+            return true;
+        }
+
+        /**
+         * @brief 在协程的调度器上登记下一个节拍
+         * @param state 等待节拍的协程状态
+         */
+        void arm(std::shared_ptr<base_coroutine_state> state) {
+            auto delay = deadline_ - state->get_dispatcher()->clock();
+            deadline_ += period_;
+            // 挂起之后当前对象可能随协程帧一起被销毁，之后只使用局部变量
+            state->suspended("interval", this);
+            // 以协程句柄为 id 的恢复任务，取消协程时由 dispatcher::cancel 一并删除
+            dispatcher::schedule_resume(state, delay);
+        }
+    };
+}
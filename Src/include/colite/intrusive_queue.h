@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+
+namespace colite::detail {
+    /**
+     * @brief 侵入式 FIFO 队列，不负责加锁，也不拥有节点
+     * @tparam Node 节点类型，须包含 `Node *next_` 成员
+     */
+    template<typename Node>
+    class intrusive_queue {
+    public:
+        intrusive_queue() = default;
+        intrusive_queue(const intrusive_queue&) = delete;
+        intrusive_queue& operator=(const intrusive_queue&) = delete;
+
+        [[nodiscard]]
+        auto empty() const -> bool {
+            return head_ == nullptr;
+        }
+
+        void push_back(Node *node) {
+            node->next_ = nullptr;
+            if (tail_) {
+                tail_->next_ = node;
+            } else {
+                head_ = node;
+            }
+            tail_ = node;
+        }
+
+        [[nodiscard]]
+        auto front() const -> Node* {
+            return head_;
+        }
+
+        auto pop_front() -> Node* {
+            auto node = head_;
+            if (node) {
+                head_ = node->next_;
+                if (!head_) {
+                    tail_ = nullptr;
+                }
+                node->next_ = nullptr;
+            }
+            return node;
+        }
+
+        /**
+         * @brief 将 other 中的所有节点按原顺序放到队首
+         */
+        void splice_front(intrusive_queue& other) {
+            if (other.empty()) {
+                return;
+            }
+            other.tail_->next_ = head_;
+            if (!tail_) {
+                tail_ = other.tail_;
+            }
+            head_ = other.head_;
+            other.head_ = other.tail_ = nullptr;
+        }
+
+        /**
+         * @brief 将 other 中的所有节点按原顺序追加到队尾
+         */
+        void splice_back(intrusive_queue& other) {
+            if (other.empty()) {
+                return;
+            }
+            if (tail_) {
+                tail_->next_ = other.head_;
+            } else {
+                head_ = other.head_;
+            }
+            tail_ = other.tail_;
+            other.head_ = other.tail_ = nullptr;
+        }
+
+        /**
+         * @brief 按顺序取出至多 limit 个满足条件的节点，追加到 to 的末尾
+         * @return 取出的节点数
+         */
+        template<typename Predicate>
+        auto take_if(intrusive_queue& to, size_t limit, Predicate&& predicate) -> size_t {
+            size_t taken = 0;
+            Node *prev = nullptr;
+            for (auto node = head_; node && taken < limit;) {
+                auto next = node->next_;
+                if (predicate(*node)) {
+                    if (prev) {
+                        prev->next_ = next;
+                    } else {
+                        head_ = next;
+                    }
+                    if (tail_ == node) {
+                        tail_ = prev;
+                    }
+                    to.push_back(node);
+                    taken++;
+                } else {
+                    prev = node;
+                }
+                node = next;
+            }
+            return taken;
+        }
+
+    private:
+        Node *head_ = nullptr;
+        Node *tail_ = nullptr;
+    };
+}
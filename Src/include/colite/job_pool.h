@@ -0,0 +1,153 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <new>
+#include "colite/callable.h"
+#include "colite/port.h"
+#include "colite/intrusive_queue.h"
+
+namespace colite::detail {
+    // 任务的冷数据：只在执行任务或检查带条件的任务时访问
+    struct job_payload {
+        colite::callable<void()> callable_;
+        colite::callable<bool()> predicate_;
+    };
+
+    // 任务的热数据：调度器每轮都要检查的字段，在分块中连续存放，与 job_payload 分开
+    struct job_header {
+        job_header *next_ = nullptr;
+        void *id_ = nullptr;
+        colite::port::time_point ready_time_ {};
+        job_payload *payload_ = nullptr;
+        // 可作废任务的作废标记（见 dispatcher::dispatch_revocable），置位之后任务不论是否到期都立即出队并被跳过
+        const std::atomic<bool> *tombstone_ = nullptr;
+        bool has_predicate_ = false;
+    };
+
+    using job_list = intrusive_queue<job_header>;
+
+    /**
+     * @brief 调度器的任务存储：任务记录按块分配，热数据与冷数据分开存放，空闲的记录经由空闲链表复用，
+     *        记录的地址在任务池的生命周期内保持不变。任务池本身不负责加锁
+     */
+    class job_pool {
+    public:
+        job_pool() = default;
+
+        ~job_pool() {
+            while (chunks_) {
+                auto next = chunks_->next_;
+                chunks_->~chunk();
+                colite::port::free(chunks_);
+                chunks_ = next;
+            }
+        }
+
+        job_pool(const job_pool&) = delete;
+        job_pool& operator=(const job_pool&) = delete;
+
+        /**
+         * @brief 取得一条空闲的记录并写入任务
+         * @param id 任务 id
+         * @param ready_time 就绪时间
+         * @param callable 任务
+         * @param predicate 就绪条件，可以为空
+         * @param tombstone 作废标记，可以为空
+         * @return 任务记录
+         */
+        auto acquire(
+            void *id,
+            colite::port::time_point ready_time,
+            colite::callable<void()>&& callable,
+            colite::callable<bool()>&& predicate,
+            const std::atomic<bool> *tombstone = nullptr
+        ) -> job_header* {
+            if (free_.empty()) {
+                grow();
+            }
+            auto header = free_.pop_front();
+            header->id_ = id;
+            header->ready_time_ = ready_time;
+            header->tombstone_ = tombstone;
+            header->has_predicate_ = static_cast<bool>(predicate);
+            ::new (header->payload_) job_payload { std::move(callable), std::move(predicate) };
+            return header;
+        }
+
+        /**
+         * @brief 回收记录，其任务须已通过 destroy 析构
+         */
+        void recycle(job_header *header) {
+            free_.push_back(header);
+        }
+
+        void recycle(job_list& headers) {
+            free_.splice_back(headers);
+        }
+
+        /**
+         * @brief 判断任务是否就绪，只有无条件的任务未就绪时不访问冷数据
+         * @param now 调度器在本轮循环中读取的当前时间
+         */
+        [[nodiscard]]
+        static auto ready(const job_header& header, colite::port::time_point now) -> bool {
+            if (header.ready_time_ > now) {
+                // 已作废的任务不等到期，立即出队
+                return revoked(header);
+            }
+            return !header.has_predicate_ || revoked(header) || header.payload_->predicate_();
+        }
+
+        static void run(const job_header& header) {
+            if (!revoked(header)) {
+                header.payload_->callable_();
+            }
+        }
+
+        [[nodiscard]]
+        static auto revoked(const job_header& header) -> bool {
+            return header.tombstone_ && header.tombstone_->load(std::memory_order_acquire);
+        }
+
+        /**
+         * @brief 析构记录中的任务，可以在锁外调用，之后再回收记录
+         */
+        static void destroy(job_header& header) {
+            header.payload_->~job_payload();
+        }
+
+        // 无延迟的任务不需要读取时钟，总是就绪
+        static auto make_ready_time(colite::port::time_duration time) -> colite::port::time_point {
+            if (time <= colite::port::time_duration(0)) {
+                return colite::port::time_point::min();
+            }
+            return colite::port::current_time() + time;
+        }
+
+    private:
+        // 每块的记录数
+        static constexpr size_t chunk_size = 64;
+
+        struct chunk {
+            chunk *next_ = nullptr;
+            job_header headers_[chunk_size] {};
+            // job_payload 在 acquire 时构造，在 destroy 时析构
+            alignas(job_payload) std::byte payloads_[chunk_size * sizeof(job_payload)];
+        };
+
+        chunk *chunks_ = nullptr;
+        job_list free_ {};
+
+        void grow() {
+            auto block = ::new (colite::port::calloc(1, sizeof(chunk))) chunk {};
+            block->next_ = chunks_;
+            chunks_ = block;
+            for (size_t i = 0; i < chunk_size; i++) {
+                auto& header = block->headers_[i];
+                header.payload_ = reinterpret_cast<job_payload*>(block->payloads_ + i * sizeof(job_payload));
+                free_.push_back(&header);
+            }
+        }
+    };
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <coroutine>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include "colite/port.h"
+#include "colite/state.h"
+#include "colite/expected.h"
+#include "colite/dispatchers.h"
+#include "colite/suspend.h"
+
+namespace colite {
+    namespace detail {
+        /**
+         * @brief 以错误结束协程：在其返回值中构造 unexpected(error)，再销毁协程帧，与执行到 co_return 相同。
+         *        调用者须持有运行该协程的权利（状态为 RUNNING），并持有其状态的强引用
+         * @param state 协程状态，其返回值为 expected
+         * @param error 错误
+         */
+        template<typename R, typename Error>
+        void finish_with_error(colite::coroutine_state<R>& state, Error&& error) {
+            static_assert(colite::traits::is_expected<R>, "colite::propagate requires the coroutine to return colite::expected.");
+            static_assert(
+                std::is_constructible_v<typename R::error_type, Error&&>,
+                "colite::propagate: the error type of the coroutine cannot be constructed from the propagated error."
+            );
+            state.emplace_return_value(colite::unexpected<typename R::error_type>(std::forward<Error>(error)));
+            auto handle = state.get_handle();
+            [[maybe_unused]] auto finished = state.transition(coroutine_status::RUNNING, coroutine_status::FINISHED);
+            colite_assert(finished);
+            // 之后等待者由该协程的完成任务恢复，与正常结束时相同
+            handle.destroy();
+        }
+
+        // 返回值为 expected 的协程是否以错误结束
+        template<typename R>
+        auto finished_with_error(colite::coroutine_state<R>& state) -> bool {
+            if (state.get_status() != coroutine_status::FINISHED) {
+                return false;
+            }
+            auto result = state.peek_return_value();
+            return result && !result->has_value();
+        }
+
+        /**
+         * @brief colite::propagate(child) 的等待体。子协程以错误结束时，由其交接函数直接以该错误结束等待者，等待者不再被恢复
+         * @tparam R 子协程的返回值类型，为 expected
+         */
+        template<typename R>
+        class propagate_awaiter {
+            static_assert(colite::traits::is_expected<R>, "colite::propagate requires a child returning colite::expected.");
+        public:
+            explicit propagate_awaiter(colite::suspend<R>&& child): child_(std::move(child)) {
+                colite_assert(child_);
+            }
+
+            [[nodiscard]]
+            auto await_ready() const -> bool {
+                // 已以错误结束时仍需挂起，由 await_suspend 结束当前协程
+                if (child_.state_->get_status() != coroutine_status::FINISHED) {
+                    return false;
+                }
+                auto result = child_.state_->peek_return_value();
+                return !result || result->has_value();
+            }
+
+            template<typename Promise>
+            auto await_suspend(std::coroutine_handle<Promise> handle) -> bool {
+                auto state = handle.promise().get_state();
+                using parent_result = typename std::remove_cvref_t<decltype(*state)>::result_type;
+                auto child = child_.state_;
+                if (finished_with_error(*child)) {
+                    finish_with_error(*state, std::move(child->peek_return_value()->error()));
+                    return true;
+                }
+                if (child->get_status() == coroutine_status::CREATED) {
+                    if (!child->get_cancellation()) {
+                        child->set_cancellation(state->get_cancellation());
+                    }
+                    state->get_dispatcher()->launch_internal(child_, state->get_priority());
+                }
+                child->set_completion(&complete<parent_result>);
+                // 挂起之后当前对象可能随协程帧一起被销毁，之后只使用局部变量
+                state->suspended("propagate", child->get_handle().address());
+                if (child->await(state)) {
+                    return true;
+                }
+                // 子协程在登记等待者之前就已经结束
+                if (!state->try_resume()) {
+                    return true;
+                }
+                if (finished_with_error(*child)) {
+                    finish_with_error(*state, std::move(child->peek_return_value()->error()));
+                    return true;
+                }
+#ifdef COLITE_NO_EXCEPTIONS
+                if (child->get_status() == coroutine_status::CANCELED) {
+                    state->suspended("canceled");
+                    colite::dispatcher::request_cancel(*state);
+                    return true;
+                }
+#endif
+                return false;
+            }
+
+            auto await_resume() -> typename R::value_type {
+                child_.check_resume();
+                if constexpr (!std::is_void_v<typename R::value_type>) {
+                    // 直接从子协程状态中的 expected 移出值，只移动一次
+                    return *std::move(*child_.state_->peek_return_value());
+                }
+            }
+
+        private:
+            colite::suspend<R> child_;
+
+            // 子协程的交接函数：以错误结束时直接结束等待者，被取消时（没有异常）一并取消等待者，否则恢复等待者
+            template<typename ParentResult>
+            static void complete(colite::base_coroutine_state& child_base, const std::shared_ptr<colite::base_coroutine_state>& awaiter) {
+                auto& child = static_cast<colite::coroutine_state<R>&>(child_base);
+                if (finished_with_error(child)) {
+                    // 等待者在此期间被请求取消时照常恢复，由恢复流程完成取消
+                    if (!awaiter->is_cancel_requested() && awaiter->try_resume()) {
+                        auto& state = static_cast<colite::coroutine_state<ParentResult>&>(*awaiter);
+                        finish_with_error(state, std::move(child.peek_return_value()->error()));
+                        return;
+                    }
+                }
+#ifdef COLITE_NO_EXCEPTIONS
+                if (child.get_status() == coroutine_status::CANCELED) {
+                    colite::dispatcher::request_cancel(*awaiter);
+                    return;
+                }
+#endif
+                colite::dispatcher::schedule_resume(awaiter);
+            }
+        };
+
+        /**
+         * @brief colite::propagate(result) 的等待体：有值时不挂起，为错误时在 await_suspend 中结束当前协程
+         */
+        template<typename T, typename E>
+        class propagate_value_awaiter {
+        public:
+            explicit propagate_value_awaiter(colite::expected<T, E>&& result): result_(std::move(result)) {  }
+
+            [[nodiscard]]
+            auto await_ready() const noexcept -> bool {
+                return result_.has_value();
+            }
+
+            template<typename Promise>
+            void await_suspend(std::coroutine_handle<Promise> handle) {
+                // 协程帧连同 result_ 一起销毁，错误先移入返回值
+                auto state = handle.promise().get_state();
+                finish_with_error(*state, std::move(result_).error());
+            }
+
+            auto await_resume() -> T {
+                if constexpr (!std::is_void_v<T>) {
+                    return *std::move(result_);
+                }
+            }
+
+        private:
+            colite::expected<T, E> result_;
+        };
+    }
+
+    /**
+     * @brief 传递子协程的错误：`auto user = co_await colite::propagate(find_user(id));`
+     *        子协程的结果有值时得到其值；为错误时当前协程直接以该错误结束（返回 unexpected(error)），
+     *        不再被恢复，也不经过异常，其等待者与正常结束时一样被恢复。当前协程的返回值须为 expected，
+     *        且其错误类型可由子协程的错误类型构造。子协程尚未启动时在当前协程的调度器上启动
+     * @param child 返回值为 expected 的子协程
+     * @return 等待体，`co_await` 的结果为子协程结果的值
+     */
+    template<typename T, typename E>
+    auto propagate(colite::suspend<colite::expected<T, E>>&& child) -> detail::propagate_awaiter<colite::expected<T, E>> {
+        return detail::propagate_awaiter<colite::expected<T, E>>(std::move(child));
+    }
+
+    /**
+     * @brief 传递同步调用的错误：`auto header = co_await colite::propagate(parse_header(buffer));`，规则同上
+     * @param result 结果
+     * @return 等待体，有值时不挂起
+     */
+    template<typename T, typename E>
+    auto propagate(colite::expected<T, E>&& result) -> detail::propagate_value_awaiter<T, E> {
+        return detail::propagate_value_awaiter<T, E>(std::move(result));
+    }
+}
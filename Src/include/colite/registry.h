@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdio>
+#include <source_location>
+#include <vector>
+#include "colite/allocator.h"
+#include "colite/port.h"
+#include "colite/spin_lock.h"
+
+namespace colite {
+    class base_coroutine_state;
+
+    enum class coroutine_status;
+
+    enum class priority;
+
+    // 存活协程的快照
+    struct coroutine_info {
+        // 协程句柄的地址
+        const void *id = nullptr;
+        coroutine_status status {};
+        colite::priority priority {};
+        // 协程帧的大小，协程帧的分配被编译器省略时为 0
+        std::size_t frame_size = 0;
+        // 创建位置（协程函数），以分配器参数开头的协程没有记录
+        std::source_location location {};
+        // 挂起时等待的原因与对象，未挂起时为空
+        const char *wait_reason = nullptr;
+        const void *awaited = nullptr;
+        // 已挂起的时长，未挂起时为 0
+        colite::port::time_duration suspended_for {};
+    };
+
+    /**
+     * @brief 存活协程的注册表：登记在调度器上启动的协程，直到其状态析构。登记链表内嵌在协程状态中，不额外分配内存。
+     *        由 dispatcher::enable_registry() 开启，用于排查长期挂起而泄漏的协程与协程帧的内存占用
+     */
+    class coroutine_registry {
+    public:
+        coroutine_registry() = default;
+        ~coroutine_registry();
+
+        coroutine_registry(const coroutine_registry&) = delete;
+        coroutine_registry& operator=(const coroutine_registry&) = delete;
+
+        /**
+         * @brief 登记协程，由调度器在启动协程时调用
+         */
+        void attach(base_coroutine_state *state);
+
+        /**
+         * @brief 注销协程，由 base_coroutine_state 在析构时调用
+         */
+        void detach(base_coroutine_state *state);
+
+        /**
+         * @brief 获取所有已登记协程的快照，可在任意线程调用
+         * @return
+         */
+        [[nodiscard]]
+        auto snapshot() -> std::vector<coroutine_info, colite::allocator::allocator<coroutine_info>>;
+
+        /**
+         * @brief 已登记的协程数量
+         * @return
+         */
+        [[nodiscard]]
+        auto size() -> std::size_t;
+
+        /**
+         * @brief 将所有已登记协程的快照以文本输出，按挂起时长从长到短排列，可在任意线程调用
+         * @param out 输出的文件
+         */
+        void dump(std::FILE *out = stderr);
+
+    private:
+        colite::port::spin_lock lock_ {};
+        // 已登记协程的侵入式链表
+        base_coroutine_state *head_ = nullptr;
+        std::size_t size_ = 0;
+    };
+}
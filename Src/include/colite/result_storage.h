@@ -0,0 +1,94 @@
+#pragma once
+
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "colite/port.h"
+
+namespace colite::detail {
+    // 足够小且可平凡复制的返回值不记录是否有值：返回值只在协程正常结束后读取，析构时也无需操作
+    template<typename R>
+    constexpr bool compact_result = std::is_trivially_copyable_v<R> && sizeof(R) <= 2 * sizeof(void*);
+
+    /**
+     * @brief 协程返回值的存储：由 co_return 原地构造，由等待者移出。与 std::optional 不同，不要求 R 可以赋值
+     */
+    template<typename R, bool Compact = compact_result<R>>
+    class result_storage {
+    public:
+        result_storage() noexcept {  }
+
+        ~result_storage() {
+            reset();
+        }
+
+        result_storage(const result_storage&) = delete;
+        result_storage& operator=(const result_storage&) = delete;
+
+        template<typename... Args>
+        void emplace(Args&&... args) {
+            reset();
+            ::new (std::addressof(value_)) R(std::forward<Args>(args)...);
+            engaged_ = true;
+        }
+
+        /**
+         * @brief 移出返回值，存储仍持有被移动后的对象，直到 reset 或析构
+         */
+        auto take() -> R {
+            colite_assert(engaged_);
+            return std::move(value_);
+        }
+
+        /**
+         * @brief 访问返回值而不移出
+         */
+        auto get() -> R& {
+            colite_assert(engaged_);
+            return value_;
+        }
+
+        void reset() noexcept {
+            if (engaged_) {
+                value_.~R();
+                engaged_ = false;
+            }
+        }
+
+    private:
+        union {
+            R value_;
+        };
+        bool engaged_ = false;
+    };
+
+    template<typename R>
+    class result_storage<R, true> {
+    public:
+        result_storage() noexcept {  }
+
+        result_storage(const result_storage&) = delete;
+        result_storage& operator=(const result_storage&) = delete;
+
+        template<typename... Args>
+        void emplace(Args&&... args) {
+            ::new (std::addressof(value_)) R(std::forward<Args>(args)...);
+        }
+
+        auto take() -> R {
+            return value_;
+        }
+
+        auto get() -> R& {
+            return value_;
+        }
+
+        void reset() noexcept {  }
+
+    private:
+        union {
+            R value_;
+        };
+    };
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include "colite/port.h"
+#include "colite/intrusive_queue.h"
+
+namespace colite {
+    class base_coroutine_state;
+}
+
+namespace colite::detail {
+    // 内嵌在协程状态中的恢复任务节点：恢复协程的任务直接以该节点入队，不需要分配内存和类型擦除
+    struct resume_node {
+        resume_node *next_ = nullptr;
+        // 任务 id，即协程句柄的地址，用于按 id 删除任务
+        void *id_ = nullptr;
+        colite::port::time_point ready_time_ = colite::port::time_point::min();
+        // 排队期间持有协程状态
+        std::shared_ptr<base_coroutine_state> owner_ {};
+        // 节点是否已在某个队列中，一个协程同一时刻只有一个恢复任务使用该节点
+        std::atomic<bool> queued_ = false;
+    };
+
+    // 恢复任务节点的队列，不负责加锁
+    using resume_queue = intrusive_queue<resume_node>;
+}
@@ -0,0 +1,261 @@
+#pragma once
+
+#include <atomic>
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include "colite/allocator.h"
+#include "colite/port.h"
+#include "colite/spin_lock.h"
+#include "colite/state.h"
+#include "colite/dispatchers.h"
+#include "colite/suspend.h"
+
+namespace colite {
+    /**
+     * @brief 可被多个协程同时等待的协程结果：`colite::shared_suspend<T> config { load_config() };`
+     *        可以复制，所有副本共享同一次执行。第一次被等待时启动协程，结束后每个等待者在各自的调度器上被恢复，
+     *        结果以 const 引用的形式交给等待者，不会被复制
+     * @tparam T 返回值类型
+     */
+    template<typename T = void>
+    class shared_suspend {
+        struct shared_state;
+
+        // 等待者链表节点，内嵌在等待体中，随等待者的协程帧一起销毁
+        struct waiter {
+            std::shared_ptr<base_coroutine_state> state_ {};
+            waiter *prev_ = nullptr;
+            waiter *next_ = nullptr;
+            // 是否仍在链表中，由 shared_state 的锁保护
+            bool linked_ = false;
+        };
+
+        struct shared_state {
+            explicit shared_state(colite::suspend<T>&& source): source_(std::move(source)) {  }
+
+            auto is_completed() const -> bool {
+                return completed_.load(std::memory_order_acquire);
+            }
+
+            // 登记等待者，须持有锁且尚未完成
+            void link(waiter& node, std::shared_ptr<base_coroutine_state> state) {
+                node.state_ = std::move(state);
+                node.next_ = head_;
+                if (head_) {
+                    head_->prev_ = &node;
+                }
+                head_ = &node;
+                node.linked_ = true;
+            }
+
+            /**
+             * @brief 注销仍在链表中的等待者，等待者的协程帧在完成之前被销毁（如被取消）时由等待体调用
+             */
+            void remove(waiter& node) {
+                std::lock_guard locker { lock_ };
+                if (node.linked_) {
+                    unlink(node);
+                }
+            }
+
+            /**
+             * @brief 标记为已完成，并在各自的调度器上恢复所有等待者；已完成时无操作
+             * @param canceled 原协程是否被取消，被取消时等待者随之被取消
+             */
+            void complete(bool canceled) {
+                {
+                    std::lock_guard locker { lock_ };
+                    if (is_completed()) {
+                        return;
+                    }
+                    // 在发布完成状态之前写入，等待者读到完成状态之后即可读取
+                    canceled_ = canceled;
+                    completed_.store(true, std::memory_order_release);
+                }
+                // 逐个在锁内取出等待者：取出之后节点可能随协程帧一起被销毁，只使用取出的协程状态
+                while (true) {
+                    std::shared_ptr<base_coroutine_state> state {};
+                    {
+                        std::lock_guard locker { lock_ };
+                        if (!head_) {
+                            break;
+                        }
+                        state = std::move(head_->state_);
+                        unlink(*head_);
+                    }
+                    if (canceled) {
+                        dispatcher::request_cancel(*state);
+                    } else {
+                        dispatcher::schedule_resume(state);
+                    }
+                }
+            }
+
+            // 须持有锁
+            void unlink(waiter& node) {
+                if (node.prev_) {
+                    node.prev_->next_ = node.next_;
+                } else {
+                    head_ = node.next_;
+                }
+                if (node.next_) {
+                    node.next_->prev_ = node.prev_;
+                }
+                node.prev_ = nullptr;
+                node.next_ = nullptr;
+                node.linked_ = false;
+            }
+
+            colite::suspend<T> source_;
+            std::atomic<bool> started_ = false;
+            std::atomic<bool> completed_ = false;
+            colite::port::spin_lock lock_ {};
+            // 等待者链表，由 lock_ 保护
+            waiter *head_ = nullptr;
+            bool canceled_ = false;
+            std::conditional_t<std::is_void_v<T>, bool, std::optional<T>> value_ {};
+#ifndef COLITE_NO_EXCEPTIONS
+            std::exception_ptr exception_ptr_ {};
+#endif
+        };
+
+        // 驱动协程的参数，随其协程帧一起销毁：驱动协程随原协程一起被取消（COLITE_NO_EXCEPTIONS）或被销毁时，
+        // 仍以取消完成共享状态，等待者不会永远挂起
+        struct completion_guard {
+            explicit completion_guard(std::shared_ptr<shared_state> state): state_(std::move(state)) {  }
+            completion_guard(completion_guard&& other) noexcept = default;
+            completion_guard(const completion_guard&) = delete;
+            completion_guard& operator=(const completion_guard&) = delete;
+
+            ~completion_guard() {
+                if (state_) {
+                    state_->complete(true);
+                }
+            }
+
+            std::shared_ptr<shared_state> state_;
+        };
+
+        // 执行原协程并广播结果，持有共享状态直到完成
+        static auto drive(completion_guard guard) -> colite::suspend<> {
+            auto& self = guard.state_;
+#ifndef COLITE_NO_EXCEPTIONS
+            try {
+#endif
+                if constexpr (std::is_void_v<T>) {
+                    co_await std::move(self->source_);
+                } else {
+                    self->value_.emplace(co_await std::move(self->source_));
+                }
+#ifndef COLITE_NO_EXCEPTIONS
+            } catch (...) {
+                self->exception_ptr_ = std::current_exception();
+            }
+#endif
+            self->complete(false);
+        }
+
+    public:
+        class awaiter {
+        public:
+            explicit awaiter(std::shared_ptr<shared_state> state): state_(std::move(state)) {  }
+
+            awaiter(const awaiter&) = delete;
+            awaiter& operator=(const awaiter&) = delete;
+
+            ~awaiter() {
+                if (suspended_) {
+                    state_->remove(node_);
+                }
+            }
+
+            [[nodiscard]]
+            auto await_ready() const -> bool {
+                // 原协程已被取消时经由 await_suspend 取消等待者
+                return state_->is_completed() && !state_->canceled_;
+            }
+
+            template<typename Promise>
+            auto await_suspend(std::coroutine_handle<Promise> handle) -> bool {
+                std::shared_ptr<base_coroutine_state> awaiter_state = handle.promise().get_state();
+                auto shared = state_;
+                if (!shared->started_.exchange(true, std::memory_order_acq_rel)) {
+                    awaiter_state->get_dispatcher()->launch_internal(drive(completion_guard { shared })).detach();
+                }
+                suspended_ = true;
+                {
+                    // 在锁内挂起并登记：挂起之后协程帧可能被其他线程销毁，析构函数须等到登记完成才能注销节点。
+                    // 返回之后当前对象可能随协程帧一起被销毁，之后只使用局部变量
+                    std::lock_guard locker { shared->lock_ };
+                    if (!shared->is_completed()) {
+                        awaiter_state->suspended("shared_suspend", shared.get());
+                        shared->link(node_, awaiter_state);
+                        return true;
+                    }
+                }
+#ifdef COLITE_NO_EXCEPTIONS
+                if (shared->canceled_) {
+                    awaiter_state->suspended("shared_suspend", shared.get());
+                    dispatcher::request_cancel(*awaiter_state);
+                    return true;
+                }
+#endif
+                return false;
+            }
+
+            auto await_resume() const -> std::add_lvalue_reference_t<std::add_const_t<T>> {
+#ifndef COLITE_NO_EXCEPTIONS
+                if (state_->canceled_) {
+                    throw colite::operation_canceled("shared_suspend<T> has been canceled.");
+                }
+                if (state_->exception_ptr_) {
+                    std::rethrow_exception(state_->exception_ptr_);
+                }
+#endif
+                if constexpr (!std::is_void_v<T>) {
+                    return *state_->value_;
+                }
+            }
+
+        private:
+            std::shared_ptr<shared_state> state_;
+            // 内嵌的等待者节点，及是否已进入 await_suspend（之后才可能被登记）
+            waiter node_ {};
+            bool suspended_ = false;
+        };
+
+        shared_suspend() = default;
+
+        /**
+         * @brief 由协程构造，协程可以尚未启动，也可以已在某个调度器上启动
+         * @param coroutine 协程
+         */
+        explicit shared_suspend(colite::suspend<T>&& coroutine):
+            state_(std::allocate_shared<shared_state, colite::allocator::allocator<std::byte>>({}, std::move(coroutine)))
+        {
+        }
+
+        [[nodiscard]]
+        explicit operator bool() const { return state_ != nullptr; }
+
+        /**
+         * @brief 是否已经完成
+         * @return
+         */
+        [[nodiscard]]
+        auto is_ready() const -> bool {
+            return state_ && state_->is_completed();
+        }
+
+        auto operator co_await() const -> awaiter {
+            colite_assert(state_);
+            return awaiter { state_ };
+        }
+
+    private:
+        std::shared_ptr<shared_state> state_ {};
+    };
+}
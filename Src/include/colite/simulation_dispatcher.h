@@ -0,0 +1,311 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include "colite/port.h"
+#include "colite/dispatchers.h"
+#include "colite/basic_dispatcher.h"
+
+namespace colite {
+    // 虚拟时间的仿真调度器：所有任务运行在调用 run 的线程上，没有可运行的任务时直接跳到下一个任务的就绪时间；
+    // 同一时刻有多个任务就绪时，在其中优先级最高的任务之间由随机种子决定运行顺序，相同的种子总能复现相同的调度。
+    // 虚拟时钟属于调度器本身（见 clock()），不影响 colite::port::current_time()，多个仿真调度器可以同时存在
+    class simulation_dispatcher final: public colite::basic_dispatcher<simulation_dispatcher> {
+        friend class colite::basic_dispatcher<simulation_dispatcher>;
+
+    public:
+        class job {
+        public:
+            job(
+                void *id,
+                colite::port::time_point ready_time,
+                colite::priority priority,
+                colite::callable<void()> callable
+            ): id(id),
+               ready_time(ready_time),
+               priority(priority),
+               callable(std::move(callable))
+            {
+            }
+
+            job(
+                void *id,
+                colite::port::time_point ready_time,
+                colite::priority priority,
+                colite::callable<void()> callable,
+                colite::callable<bool()> predicate
+            ): id(id),
+               ready_time(ready_time),
+               priority(priority),
+               callable(std::move(callable)),
+               predicate(std::move(predicate))
+            {
+            }
+
+            job(
+                void *id,
+                colite::port::time_point ready_time,
+                colite::priority priority,
+                colite::callable<void()> callable,
+                const std::atomic<bool> *tombstone
+            ): id(id),
+               ready_time(ready_time),
+               priority(priority),
+               callable(std::move(callable)),
+               tombstone(tombstone)
+            {
+            }
+
+            [[nodiscard]]
+            auto ready(colite::port::time_point now) const -> bool {
+                if (predicate) {
+                    return ready_time <= now && predicate.value()();
+                } else {
+                    return ready_time <= now;
+                }
+            }
+
+            void operator()() const {
+                if (!revoked()) {
+                    callable();
+                }
+            }
+
+            // 是否已被作废（见 dispatcher::dispatch_revocable）
+            [[nodiscard]]
+            auto revoked() const -> bool {
+                return tombstone && tombstone->load(std::memory_order_acquire);
+            }
+
+            [[nodiscard]]
+            auto get_id() const -> void* { return id; }
+
+            [[nodiscard]]
+            auto get_ready_time() const -> colite::port::time_point { return ready_time; }
+
+            [[nodiscard]]
+            auto get_priority() const -> colite::priority { return priority; }
+
+        private:
+            void *id;
+            colite::port::time_point ready_time;
+            colite::priority priority;
+            colite::callable<void()> callable;
+            std::optional<colite::callable<bool()>> predicate = std::nullopt;
+            const std::atomic<bool> *tombstone = nullptr;
+        };
+
+        /**
+         * @brief 创建仿真调度器
+         * @param seed 随机种子
+         * @param start 虚拟时钟的起始时间
+         */
+        explicit simulation_dispatcher(
+            uint64_t seed = 0,
+            colite::port::time_point start = colite::port::time_point {}
+        ): random_(seed),
+           now_(start)
+        {
+        }
+
+        simulation_dispatcher(const simulation_dispatcher&) = delete;
+        simulation_dispatcher& operator=(const simulation_dispatcher&) = delete;
+
+        /**
+         * @brief 获取虚拟时钟的当前时间
+         * @return
+         */
+        [[nodiscard]]
+        auto now() const -> colite::port::time_point {
+            return now_;
+        }
+
+        [[nodiscard]]
+        auto clock() const -> colite::port::time_point override {
+            return now_;
+        }
+
+        /**
+         * @brief 运行协程，直到所有任务执行完毕
+         * @param coroutine 协程
+         * @return 协程的返回值
+         */
+        template<typename Coro>
+            requires colite::traits::is_suspend<std::remove_cvref_t<Coro>>
+        auto run(Coro&& coroutine) {
+            auto&& coro = this->launch(std::forward<Coro>(coroutine));
+            while (true) {
+                coro.check_and_throw_exception();
+                if (!step(std::nullopt)) {
+                    break;
+                }
+            }
+            if (!coro.await_ready()) {
+                colite_throw(std::runtime_error("simulation_dispatcher: the coroutine can never be resumed."));
+            }
+            return coro.await_resume();
+        }
+
+        /**
+         * @brief 运行所有在 deadline 之前就绪的任务，之后虚拟时钟停在 deadline
+         * @param deadline 截止时间
+         */
+        void run_until(colite::port::time_point deadline) {
+            while (step(deadline)) {
+                ;
+            }
+            if (now_ < deadline) {
+                now_ = deadline;
+            }
+        }
+
+        /**
+         * @brief 运行虚拟时间中的一段时长
+         * @param duration 时长
+         */
+        void run_for(colite::port::time_duration duration) {
+            run_until(now_ + duration);
+        }
+
+        /**
+         * @brief 运行一个就绪的任务，若当前没有就绪任务，则将虚拟时钟推进到下一个任务的就绪时间
+         * @param deadline 虚拟时钟不会被推进到超过该时间
+         * @return 是否运行了任务
+         */
+        auto step(std::optional<colite::port::time_point> deadline) -> bool {
+            std::optional<job> job = std::nullopt;
+            job_list revoked {};
+            {
+                std::lock_guard locker { lock_ };
+                auto picked = pick_ready_job(revoked);
+                if (!picked) {
+                    auto next = next_ready_time();
+                    if (!next || (deadline && *next > *deadline)) {
+                        return false;
+                    }
+                    now_ = *next;
+                    picked = pick_ready_job(revoked);
+                    if (!picked) {
+                        return false;
+                    }
+                }
+                job = std::move(**picked);
+                jobs_.erase(*picked);
+            }
+            job_scope scope { *this };
+            job.value()();
+            return true;
+        }
+
+    private:
+        using job_list = std::list<job, colite::allocator::allocator<job>>;
+
+        std::mutex lock_ {};
+        job_list jobs_ {};
+        std::mt19937_64 random_;
+        colite::port::time_point now_;
+
+        /**
+         * @brief 在就绪的任务中优先级最高的那些之间随机选出一个。原地遍历队列：第一遍统计候选数，第二遍取出选中的任务，
+         *        不构造候选列表。已作废的任务移入 revoked，由调用者在锁外析构，使其不再推进虚拟时钟
+         * @return 选中的任务，没有就绪的任务时为空
+         */
+        auto pick_ready_job(job_list& revoked) -> std::optional<job_list::iterator> {
+            size_t count = 0;
+            auto best = colite::priority::NORMAL;
+            for (auto it = jobs_.begin(), next = it; it != jobs_.end(); it = next) {
+                ++next;
+                if (it->revoked()) {
+                    revoked.splice(revoked.cend(), jobs_, it);
+                    continue;
+                }
+                if (!it->ready(now_)) {
+                    continue;
+                }
+                if (count == 0 || it->get_priority() < best) {
+                    best = it->get_priority();
+                    count = 0;
+                }
+                if (it->get_priority() == best) {
+                    count++;
+                }
+            }
+            if (count == 0) {
+                return std::nullopt;
+            }
+            auto index = random_() % count;
+            // 就绪条件在两遍之间变化时（例如被其他线程上的协程满足），退而取最后一个候选
+            std::optional<job_list::iterator> picked = std::nullopt;
+            for (auto it = jobs_.begin(); it != jobs_.end(); ++it) {
+                if (it->get_priority() == best && it->ready(now_)) {
+                    picked = it;
+                    if (index-- == 0) {
+                        break;
+                    }
+                }
+            }
+            return picked;
+        }
+
+        auto next_ready_time() const -> std::optional<colite::port::time_point> {
+            std::optional<colite::port::time_point> result = std::nullopt;
+            for (auto& it : jobs_) {
+                if (it.get_ready_time() > now_ && (!result || it.get_ready_time() < *result)) {
+                    result = it.get_ready_time();
+                }
+            }
+            return result;
+        }
+
+        void dispatch(
+            void *id,
+            colite::port::time_duration time,
+            colite::priority priority,
+            colite::callable<void()> callable
+        ) override {
+            std::lock_guard locker { lock_ };
+            jobs_.emplace_back(id, now_ + time, priority, std::move(callable));
+        }
+
+        void dispatch(
+            void *id,
+            colite::port::time_duration time,
+            colite::priority priority,
+            colite::callable<void()> callable,
+            colite::callable<bool()> predicate
+        ) override {
+            std::lock_guard locker { lock_ };
+            jobs_.emplace_back(id, now_ + time, priority, std::move(callable), std::move(predicate));
+        }
+
+        void dispatch_revocable(
+            void *id,
+            colite::port::time_duration time,
+            colite::priority priority,
+            colite::callable<void()> callable,
+            const std::atomic<bool> *tombstone
+        ) override {
+            std::lock_guard locker { lock_ };
+            jobs_.emplace_back(id, now_ + time, priority, std::move(callable), tombstone);
+        }
+
+        void cancel_jobs(void *id) override {
+            job_list removed {};
+            {
+                std::lock_guard locker { lock_ };
+                for (auto it = jobs_.begin(); it != jobs_.end();) {
+                    auto next = std::next(it);
+                    if (it->get_id() == id) {
+                        removed.splice(removed.cend(), jobs_, it);
+                    }
+                    it = next;
+                }
+            }
+        }
+    };
+}
@@ -1,41 +1,122 @@
 #pragma once
 
-#include <tuple>
+#include <atomic>
 #include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <memory>
+#include <source_location>
+#include <utility>
 #include "colite/port.h"
+#include "colite/spin_lock.h"
+#include "colite/cancellation.h"
+#include "colite/registry.h"
+#include "colite/resume_queue.h"
+#include "colite/result_storage.h"
 
 namespace colite {
     class dispatcher;
 
+    template<typename Derived>
+    class basic_dispatcher;
+
     template<typename T = void>
     class suspend;
 
     namespace detail {
         template<typename C, typename R>
         class promise_type;
+
+        template<typename T>
+        class timeout_awaiter;
+
+        template<typename R>
+        class propagate_awaiter;
     }
 
     // 协程状态
+    // CREATED -> STARTED -> RUNNING <-> SUSPENDED -> FINISHED
+    //               \           \ (延迟到下一个挂起点)
+    //                +-----------+--------------------> CANCELED
     enum class coroutine_status {
         CREATED,
         STARTED,
+        RUNNING,
+        SUSPENDED,
         FINISHED,
         CANCELED
     };
 
-    class base_coroutine_state {
+    // 调度优先级：同一调度器上，较高优先级的任务先于较低优先级的任务执行，较低优先级保有少量份额以免饿死
+    enum class priority {
+        HIGH,
+        NORMAL,
+        BACKGROUND
+    };
+
+    // 优先级的数量
+    constexpr size_t priority_count = 3;
+
+    class base_coroutine_state: public std::enable_shared_from_this<base_coroutine_state> {
         template<typename C, typename R>
         friend class colite::detail::promise_type;
 
         template<typename T>
         friend class colite::suspend;
+
+        friend class colite::cancellation_state;
+
+        friend class colite::coroutine_registry;
     public:
+        // 协程结束或被取消之后交给等待者的方式，见 set_completion
+        using completion_handler = void (*)(base_coroutine_state& self, const std::shared_ptr<base_coroutine_state>& awaiter);
+
+        base_coroutine_state() = default;
+        base_coroutine_state(const base_coroutine_state&) = delete;
+        base_coroutine_state& operator=(const base_coroutine_state&) = delete;
+
+        ~base_coroutine_state() {
+            if (cancellation_) {
+                cancellation_->detach(this);
+            }
+            if (registry_) {
+                registry_->detach(this);
+            }
+        }
+
+        /**
+         * @brief 绑定取消令牌，只能在协程启动之前绑定一次
+         * @param cancellation 令牌的共享状态
+         */
+        void set_cancellation(std::shared_ptr<cancellation_state> cancellation) {
+            if (!cancellation || cancellation == cancellation_) {
+                return;
+            }
+            colite_assert(!cancellation_);
+            cancellation_ = std::move(cancellation);
+            cancellation_->attach(this);
+        }
+
+        [[nodiscard]]
+        auto get_cancellation() const -> const std::shared_ptr<cancellation_state>& {
+            return cancellation_;
+        }
+
+        /**
+         * @brief 协程绑定的取消令牌是否已请求取消
+         * @return
+         */
+        [[nodiscard]]
+        auto is_cancellation_requested() const -> bool {
+            return cancellation_ && cancellation_->is_cancellation_requested();
+        }
+
         /**
          * @brief 设置调度器
          * @param dispatcher
          */
         void set_dispatcher(dispatcher *dispatcher) {
-            dispatcher_ = dispatcher;
+            dispatcher_.store(dispatcher, std::memory_order_release);
         }
 
         /**
@@ -44,18 +125,77 @@ namespace colite {
          */
         [[nodiscard]]
         auto get_dispatcher() const -> dispatcher* {
-            return dispatcher_;
+            return dispatcher_.load(std::memory_order_acquire);
         }
 
         /**
-         * @brief 设置该协程的等待状态
-         * @param awaiter_handle
-         * @param awaiter_dispatcher
+         * @brief 设置调度优先级，被该协程等待的子协程在启动时继承该优先级
+         * @param priority
          */
-        void await(const std::coroutine_handle<> awaiter_handle, dispatcher *const awaiter_dispatcher) {
+        void set_priority(colite::priority priority) {
+            priority_.store(priority, std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 获取调度优先级
+         * @return
+         */
+        [[nodiscard]]
+        auto get_priority() const -> colite::priority {
+            return priority_.load(std::memory_order_relaxed);
+        }
+
+        /**
+         * @brief 获取协程句柄
+         * @return
+         */
+        [[nodiscard]]
+        auto get_handle() const -> std::coroutine_handle<> {
+            return handle_;
+        }
+
+        /**
+         * @brief 记录协程的创建位置与协程帧的大小，由 promise 在构造时调用
+         * @param location 创建位置
+         * @param frame_size 协程帧的大小
+         */
+        void set_origin(const std::source_location& location, std::size_t frame_size) {
+            location_ = location;
+            frame_size_ = frame_size;
+        }
+
+        /**
+         * @brief 获取内嵌的恢复任务节点，由调度器使用
+         * @return
+         */
+        [[nodiscard]]
+        auto get_resume_node() -> detail::resume_node& {
+            return resume_node_;
+        }
+
+        /**
+         * @brief 设置该协程的等待者
+         * @param awaiter 等待者协程的状态
+         * @return 若返回 false，则该协程在此之前已经结束，等待者不应挂起
+         */
+        auto await(std::shared_ptr<base_coroutine_state> awaiter) -> bool {
             colite_assert(is_awaited() == false);
-            awaiter_handle_ = awaiter_handle;
-            awaiter_dispatcher_ = awaiter_dispatcher;
+            awaiter_ = std::move(awaiter);
+            auto expected = handoff::EMPTY;
+            return handoff_.compare_exchange_strong(expected, handoff::AWAITING, std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        /**
+         * @brief 设置该协程结束或被取消之后如何交给等待者，由等待体在 await() 之前设置；为空时恢复等待者
+         * @param completion 交接函数，以该协程与等待者的状态调用
+         */
+        void set_completion(completion_handler completion) {
+            completion_ = completion;
+        }
+
+        [[nodiscard]]
+        auto get_completion() const -> completion_handler {
+            return completion_;
         }
 
         /**
@@ -64,12 +204,19 @@ namespace colite {
          */
         [[nodiscard]]
         auto is_awaited() const -> bool {
-            return awaiter_handle_ && awaiter_dispatcher_;
+            return awaiter_ != nullptr;
         }
 
-        [[nodiscard]]
-        auto awaiter() const {
-            return std::make_tuple(awaiter_handle_, awaiter_dispatcher_);
+        /**
+         * @brief 协程结束或被取消后取出等待者，与 await() 竞争，二者中仅后到者能拿到等待者；
+         *        多次调用时至多一次能拿到等待者，因此等待者只会被恢复一次
+         * @return 等待者协程的状态，若还没有等待者或已被取出则返回空
+         */
+        auto take_awaiter() -> std::shared_ptr<base_coroutine_state> {
+            if (handoff_.exchange(handoff::DONE, std::memory_order_acq_rel) == handoff::AWAITING) {
+                return awaiter_;
+            }
+            return nullptr;
         }
 
         /**
@@ -77,43 +224,236 @@ namespace colite {
          * @return 状态
          */
         [[nodiscard]]
-        auto get_status() const -> coroutine_status { return status_; }
+        auto get_status() const -> coroutine_status { return status_.load(std::memory_order_acquire); }
 
         /**
-         * @brief 设置协程状态
+         * @brief 以 CAS 的方式切换协程状态
+         * @param from 期望的当前状态
+         * @param to 目标状态
+         * @return 是否切换成功
          */
-        void set_status(coroutine_status status) { status_ = status; }
+        auto transition(coroutine_status from, coroutine_status to) -> bool {
+            return status_.compare_exchange_strong(from, to, std::memory_order_acq_rel, std::memory_order_acquire);
+        }
+
+        /**
+         * @brief 尝试恢复协程：STARTED/SUSPENDED -> RUNNING
+         * @return 是否获得了恢复该协程的权利
+         */
+        auto try_resume() -> bool {
+            auto status = get_status();
+            while (status == coroutine_status::STARTED || status == coroutine_status::SUSPENDED) {
+                if (status_.compare_exchange_weak(status, coroutine_status::RUNNING, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief 协程到达挂起点：RUNNING -> SUSPENDED。调用之后该协程可能随时被其他线程恢复或销毁
+         * @param reason 等待的原因，供注册表展示，须为静态字符串
+         * @param awaited 等待的对象，供注册表展示
+         */
+        void suspended(const char *reason = nullptr, const void *awaited = nullptr) {
+            wait_reason_.store(reason, std::memory_order_relaxed);
+            awaited_.store(awaited, std::memory_order_relaxed);
+            // 只有登记到注册表的协程才读取时钟
+            if (registry_) {
+                suspended_at_.store(colite::port::current_time(), std::memory_order_relaxed);
+            }
+            [[maybe_unused]] auto ok = transition(coroutine_status::RUNNING, coroutine_status::SUSPENDED);
+            colite_assert(ok);
+        }
+
+        /**
+         * @brief 请求取消协程。若协程正在运行，则取消被推迟到其下一个挂起点
+         * @return 若返回 true，则调用者获得了销毁该协程的权利（状态已切换为 CANCELED）
+         */
+        auto request_cancel() -> bool {
+            cancel_requested_.store(true, std::memory_order_seq_cst);
+            auto status = status_.load(std::memory_order_seq_cst);
+            while (true) {
+                switch (status) {
+                    case coroutine_status::RUNNING:
+                    case coroutine_status::FINISHED:
+                    case coroutine_status::CANCELED:
+                        return false;
+                    default:
+                        break;
+                }
+                if (status_.compare_exchange_weak(status, coroutine_status::CANCELED, std::memory_order_seq_cst)) {
+                    return true;
+                }
+            }
+        }
+
+        /**
+         * @brief 是否已请求取消
+         * @return
+         */
+        [[nodiscard]]
+        auto is_cancel_requested() const -> bool {
+            return cancel_requested_.load(std::memory_order_seq_cst);
+        }
+
+        /**
+         * @brief 关闭容量闸门：该协程下一次被恢复之前，须等到调度器在指定优先级有空位，由调度器使用
+         * @param owner 容量已满的调度器
+         * @param priority 优先级
+         */
+        void close_capacity_gate(dispatcher *owner, colite::priority priority) {
+            capacity_gate_priority_ = priority;
+            capacity_gate_.store(owner, std::memory_order_release);
+        }
+
+        void open_capacity_gate() {
+            capacity_gate_.store(nullptr, std::memory_order_relaxed);
+        }
+
+        [[nodiscard]]
+        auto get_capacity_gate() const -> dispatcher* {
+            return capacity_gate_.load(std::memory_order_acquire);
+        }
+
+        [[nodiscard]]
+        auto get_capacity_gate_priority() const -> colite::priority {
+            return capacity_gate_priority_;
+        }
+
+        /**
+         * @brief 锁住完成任务的登记：start_on 在首次恢复之后登记完成任务，协程在此期间 switch_to 到其他线程后
+         *        可能同时改登记，两者须互斥。持锁期间只做入队与按 id 删除任务
+         */
+        void lock_completion() {
+            while (completion_busy_.exchange(true, std::memory_order_acquire)) {
+                colite_cpu_relax();
+            }
+        }
+
+        void unlock_completion() {
+            completion_busy_.store(false, std::memory_order_release);
+        }
+
+        /**
+         * @brief 改登记完成任务所在的调度器，须在 lock_completion 与 unlock_completion 之间调用
+         * @param dispatcher 新的调度器
+         * @return 之前登记的调度器，尚未登记时为空
+         */
+        auto exchange_completion_dispatcher(dispatcher *dispatcher) -> colite::dispatcher* {
+            return std::exchange(completion_dispatcher_, dispatcher);
+        }
+
+        /**
+         * @brief 作废 with_timeout 为该协程布置的定时器，O(1)：定时器任务由调度器在扫描队列时跳过，不必按 id 查找删除
+         */
+        void disarm_timeout() {
+            timeout_disarmed_.store(true, std::memory_order_release);
+        }
+
+        // with_timeout 的定时器的作废标记，作为 dispatch_revocable 的 tombstone
+        [[nodiscard]]
+        auto get_timeout_tombstone() const -> const std::atomic<bool>* {
+            return &timeout_disarmed_;
+        }
 
     protected:
         // 当前协程的调度器
-        dispatcher* dispatcher_ = nullptr;
+        std::atomic<dispatcher*> dispatcher_ = nullptr;
+
+        // 当前协程的调度优先级
+        std::atomic<colite::priority> priority_ = colite::priority::NORMAL;
+
+        // 取消令牌，及其登记链表中的前后节点（由 cancellation_state 的锁保护）
+        std::shared_ptr<cancellation_state> cancellation_ {};
+        base_coroutine_state *cancellation_prev_ = nullptr;
+        base_coroutine_state *cancellation_next_ = nullptr;
+
+        // 当前协程的句柄
+        std::coroutine_handle<> handle_{};
 
         // 当前协程的状态
-        volatile coroutine_status status_ = coroutine_status::CREATED;
+        std::atomic<coroutine_status> status_ = coroutine_status::CREATED;
+        std::atomic<bool> cancel_requested_ = false;
+
+        // 容量闸门：不为空时，协程在该调度器的指定优先级有空位之后才能被恢复
+        std::atomic<dispatcher*> capacity_gate_ = nullptr;
+        colite::priority capacity_gate_priority_ = colite::priority::NORMAL;
+
+        // with_timeout 的定时器是否已作废
+        std::atomic<bool> timeout_disarmed_ = false;
+
+        // 完成任务所在的调度器，由 completion_busy_ 保护
+        dispatcher *completion_dispatcher_ = nullptr;
+        std::atomic<bool> completion_busy_ = false;
+#ifndef COLITE_NO_EXCEPTIONS
         std::exception_ptr exception_ptr_{};
+#endif
+
+        // 等待者的交接状态：EMPTY -> AWAITING（已登记等待者）-> DONE（已结束，等待者已被取出）
+        enum class handoff {
+            EMPTY,
+            AWAITING,
+            DONE
+        };
 
         // 等待这个协程的人
-        std::coroutine_handle<> awaiter_handle_{};
-        dispatcher *awaiter_dispatcher_ = nullptr;
+        std::shared_ptr<base_coroutine_state> awaiter_{};
+        std::atomic<handoff> handoff_ = handoff::EMPTY;
+        completion_handler completion_ = nullptr;
+
+        // 恢复该协程的任务节点
+        detail::resume_node resume_node_ {};
+
+        // 登记该协程的注册表，及其登记链表中的前后节点（由注册表的锁保护）
+        coroutine_registry *registry_ = nullptr;
+        base_coroutine_state *registry_prev_ = nullptr;
+        base_coroutine_state *registry_next_ = nullptr;
+
+        // 创建位置与协程帧的大小
+        std::source_location location_ {};
+        std::size_t frame_size_ = 0;
+
+        // 最近一次挂起时等待的原因、对象与时间
+        std::atomic<const char*> wait_reason_ = nullptr;
+        std::atomic<const void*> awaited_ = nullptr;
+        std::atomic<colite::port::time_point> suspended_at_ {};
     };
 
     template<typename R = void>
     class coroutine_state: public base_coroutine_state {
     public:
-        void set_return_value(R&& ret) {
-            if constexpr (std::is_reference_v<R>) {
-                ret_value_ = std::addressof(ret);
-            } else {
-                ret_value_ = std::move(ret);
-            }
+        using result_type = R;
+
+        // 引用类型的返回值只记录地址
+        void set_return_value(R&& ret) requires std::is_reference_v<R> {
+            ret_value_ = std::addressof(ret);
         }
 
-        void set_return_value(const R& ret) {
-            if constexpr (std::is_reference_v<R>) {
-                ret_value_ = std::addressof(ret);
-            } else {
-                ret_value_ = ret;
+        void set_return_value(const R& ret) requires std::is_reference_v<R> {
+            ret_value_ = std::addressof(ret);
+        }
+
+        /**
+         * @brief 由 co_return 调用，在协程状态中原地构造返回值。返回值只有这一份，等待者从这里移出一次
+         * @param args 返回值的构造参数
+         */
+        template<typename... Args>
+            requires (!std::is_reference_v<R>)
+        void emplace_return_value(Args&&... args) {
+            ret_value_.emplace(std::forward<Args>(args)...);
+            has_return_value_ = true;
+        }
+
+        /**
+         * @brief 访问已写入的返回值而不取出，须在协程结束之后调用
+         * @return 返回值，协程没有写入返回值（如以异常结束）时为空
+         */
+        auto peek_return_value() -> R* requires (!std::is_reference_v<R>) {
+            if (!has_return_value_) {
+                return nullptr;
             }
+            return std::addressof(ret_value_.get());
         }
 
         auto get_return_value() -> R {
@@ -122,16 +462,18 @@ namespace colite {
             } else if constexpr (std::is_rvalue_reference_v<R>) {
                 return std::move(*ret_value_);
             } else {
-                return std::move(ret_value_).value();
+                return ret_value_.take();
             }
         }
     protected:
         using return_value_type = std::conditional_t<
             std::is_reference_v<R>,
             std::add_pointer_t<std::remove_reference_t<R>>,
-            std::optional<R>
+            detail::result_storage<R>
         >;
         return_value_type ret_value_{};
+        // 由结束的协程写入，等待者在观察到协程结束之后读取，不需要原子操作
+        bool has_return_value_ = false;
     };
 
     template<>
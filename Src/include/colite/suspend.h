@@ -1,12 +1,39 @@
 #pragma once
 
 #include <coroutine>
-#include <optional>
+#include <cstddef>
 #include <memory>
+#include <memory_resource>
+#include <optional>
+#include <source_location>
+#include <type_traits>
+#include <utility>
 #include "colite/traits.h"
 #include "colite/dispatchers.h"
 
 namespace colite::detail {
+    // operator new 分配的协程帧大小，由紧随其后构造的 promise 取走；协程帧的分配被编译器省略时为 0
+    inline thread_local std::size_t allocated_frame_size = 0;
+
+    // 协程帧之后的尾部，记录释放该协程帧的方式
+    struct frame_trailer {
+        void (*deallocate_)(void *frame, std::size_t n);
+    };
+
+    // 用户分配器分配协程帧的单位：协程帧须按 operator new 的默认对齐方式对齐，以该对齐的单元为元素类型分配
+    struct alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) frame_unit {
+        std::byte bytes_[__STDCPP_DEFAULT_NEW_ALIGNMENT__];
+    };
+
+    /**
+     * @brief 协程的 promise 基类。协程的参数以 `std::allocator_arg_t, Alloc`（或 `std::pmr::memory_resource*`）开头时，
+     *        协程帧与协程状态都由该分配器分配：
+     *        ```
+     *        auto handle(std::allocator_arg_t, std::pmr::memory_resource *arena, request r) -> colite::suspend<>;
+     *        co_await handle(std::allocator_arg, &per_request_buffer, r);
+     *        ```
+     *        分配器须在协程帧与持有协程的 suspend 都被销毁之后才能释放内存
+     */
     template<typename Promise>
     class base_promise {
         template<typename T>
@@ -15,18 +42,186 @@ namespace colite::detail {
         std::suspend_always initial_suspend() noexcept { return {}; }
 
         void* operator new(std::size_t n) {
-            return colite::port::calloc(n, sizeof(std::byte));
+            allocated_frame_size = n;
+            auto frame = colite::port::calloc(trailer_offset(n) + sizeof(frame_trailer), sizeof(std::byte));
+            ::new (trailer_of(frame, n)) frame_trailer {
+                .deallocate_ = [] (void *frame, std::size_t) { colite::port::free(frame); }
+            };
+            return frame;
+        }
+
+        template<typename Alloc, typename... Args>
+        void* operator new(std::size_t n, std::allocator_arg_t, const Alloc& alloc, const Args&...) {
+            return allocate_frame(n, rebind_allocator(alloc));
+        }
+
+        // 成员函数协程的第一个参数为对象本身
+        template<typename This, typename Alloc, typename... Args>
+        void* operator new(std::size_t n, const This&, std::allocator_arg_t, const Alloc& alloc, const Args&...) {
+            return allocate_frame(n, rebind_allocator(alloc));
         }
 
-        void operator delete(void* ptr, size_t n) noexcept {
-            colite::port::free(ptr);
+        void operator delete(void* ptr, std::size_t n) noexcept {
+            trailer_of(ptr, n)->deallocate_(ptr, n);
         }
 
     protected:
         std::coroutine_handle<Promise> this_handle_;
+
+        /**
+         * @brief 将用户提供的分配器转换为分配 frame_unit 的分配器，memory_resource 同样按 frame_unit 的对齐方式分配
+         */
+        template<typename Alloc>
+        static auto rebind_allocator(const Alloc& alloc) {
+            if constexpr (std::is_convertible_v<Alloc, std::pmr::memory_resource*>) {
+                return std::pmr::polymorphic_allocator<frame_unit>(alloc);
+            } else {
+                return typename std::allocator_traits<Alloc>::template rebind_alloc<frame_unit>(alloc);
+            }
+        }
+
+        /**
+         * @brief 用分配器创建协程状态
+         */
+        template<typename State, typename Alloc>
+        static auto make_state(const Alloc& alloc) -> std::shared_ptr<State> {
+            return std::allocate_shared<State>(alloc);
+        }
+
+        /**
+         * @brief 记录协程的创建位置与协程帧的大小，供注册表展示
+         */
+        static void record_origin(colite::base_coroutine_state& state, const std::source_location& location) {
+            state.set_origin(location, std::exchange(allocated_frame_size, 0));
+        }
+
+    private:
+        static constexpr auto trailer_offset(std::size_t n) -> std::size_t {
+            return (n + alignof(frame_trailer) - 1) / alignof(frame_trailer) * alignof(frame_trailer);
+        }
+
+        template<typename UnitAlloc>
+        static constexpr auto allocator_offset(std::size_t n) -> std::size_t {
+            auto end = trailer_offset(n) + sizeof(frame_trailer);
+            return (end + alignof(UnitAlloc) - 1) / alignof(UnitAlloc) * alignof(UnitAlloc);
+        }
+
+        // 协程帧、尾部与分配器副本共占的 frame_unit 个数，各部分相对于按 frame_unit 对齐的起始地址对齐
+        template<typename UnitAlloc>
+        static constexpr auto frame_units(std::size_t n) -> std::size_t {
+            return (allocator_offset<UnitAlloc>(n) + sizeof(UnitAlloc) + sizeof(frame_unit) - 1) / sizeof(frame_unit);
+        }
+
+        static auto trailer_of(void *frame, std::size_t n) -> frame_trailer* {
+            return reinterpret_cast<frame_trailer*>(static_cast<std::byte*>(frame) + trailer_offset(n));
+        }
+
+        // 布局：[协程帧][frame_trailer][分配器的副本]
+        template<typename UnitAlloc>
+        static auto allocate_frame(std::size_t n, UnitAlloc alloc) -> void* {
+            allocated_frame_size = n;
+            auto frame = static_cast<void*>(std::allocator_traits<UnitAlloc>::allocate(alloc, frame_units<UnitAlloc>(n)));
+            ::new (static_cast<std::byte*>(frame) + allocator_offset<UnitAlloc>(n)) UnitAlloc(alloc);
+            ::new (trailer_of(frame, n)) frame_trailer {
+                .deallocate_ = [] (void *frame, std::size_t n) {
+                    auto stored = reinterpret_cast<UnitAlloc*>(static_cast<std::byte*>(frame) + allocator_offset<UnitAlloc>(n));
+                    UnitAlloc alloc = std::move(*stored);
+                    stored->~UnitAlloc();
+                    std::allocator_traits<UnitAlloc>::deallocate(alloc, static_cast<frame_unit*>(frame), frame_units<UnitAlloc>(n));
+                }
+            };
+            return frame;
+        }
     };
 
 
+    /**
+     * @brief COLITE_NO_EXCEPTIONS 下 co_await 子协程时的交接函数：子协程被取消时一并取消等待者，否则恢复等待者
+     */
+    inline void cancel_with_child(colite::base_coroutine_state& child, const std::shared_ptr<colite::base_coroutine_state>& awaiter) {
+        if (child.get_status() == coroutine_status::CANCELED) {
+            colite::dispatcher::request_cancel(*awaiter);
+        } else {
+            colite::dispatcher::schedule_resume(awaiter);
+        }
+    }
+
+#ifdef COLITE_NO_EXCEPTIONS
+    /**
+     * @brief 取得可等待对象的等待体：有 operator co_await 时调用它，否则为该对象本身
+     */
+    template<typename Awaitable>
+    auto get_awaiter(Awaitable&& awaitable) -> decltype(auto) {
+        if constexpr (requires { std::forward<Awaitable>(awaitable).operator co_await(); }) {
+            return std::forward<Awaitable>(awaitable).operator co_await();
+        } else if constexpr (requires { operator co_await(std::forward<Awaitable>(awaitable)); }) {
+            return operator co_await(std::forward<Awaitable>(awaitable));
+        } else {
+            return std::forward<Awaitable>(awaitable);
+        }
+    }
+
+    /**
+     * @brief COLITE_NO_EXCEPTIONS 下 await_transform 的结果。协程绑定的取消令牌已被请求取消时总是挂起，
+     *        由调度器在挂起之后销毁协程，不论被等待的对象是否会挂起；否则转发给被等待的对象
+     * @tparam Awaitable 被等待的对象，可以是引用
+     */
+    template<typename Awaitable>
+    class cancel_point {
+        using awaiter_type = decltype(get_awaiter(std::declval<Awaitable>()));
+    public:
+        cancel_point(colite::base_coroutine_state *canceled, Awaitable&& awaitable):
+            canceled_(canceled),
+            awaitable_(std::forward<Awaitable>(awaitable)),
+            awaiter_(get_awaiter(std::forward<Awaitable>(awaitable_)))
+        {  }
+
+        [[nodiscard]]
+        auto await_ready() -> bool {
+            return !canceled_ && awaiter_.await_ready();
+        }
+
+        template<typename Promise>
+        auto await_suspend(std::coroutine_handle<Promise> handle) {
+            using result_type = decltype(awaiter_.await_suspend(handle));
+            if constexpr (std::is_void_v<result_type>) {
+                if (canceled_) {
+                    cancel(*canceled_);
+                    return;
+                }
+                awaiter_.await_suspend(handle);
+            } else if constexpr (std::is_same_v<result_type, bool>) {
+                if (canceled_) {
+                    cancel(*canceled_);
+                    return true;
+                }
+                return awaiter_.await_suspend(handle);
+            } else {
+                if (canceled_) {
+                    cancel(*canceled_);
+                    return std::coroutine_handle<>(std::noop_coroutine());
+                }
+                return std::coroutine_handle<>(awaiter_.await_suspend(handle));
+            }
+        }
+
+        auto await_resume() -> decltype(auto) {
+            return awaiter_.await_resume();
+        }
+
+    private:
+        // 取消被推迟到挂起点：登记取消请求之后挂起，调度器在协程挂起之后将其销毁
+        static void cancel(colite::base_coroutine_state& state) {
+            state.request_cancel();
+            state.suspended("canceled");
+        }
+
+        colite::base_coroutine_state *canceled_;
+        Awaitable awaitable_;
+        awaiter_type awaiter_;
+    };
+#endif
+
     template<typename Coro, typename R>
     class promise_type: public base_promise<promise_type<Coro, R>> {
         template<typename T>
@@ -38,25 +233,79 @@ namespace colite::detail {
         using base_promise_t::operator new;
         using base_promise_t::operator delete;
 
+        // 默认参数在协程函数中求值，记录的是协程函数的位置
+        explicit promise_type(const std::source_location& location = std::source_location::current()):
+            state_(base_promise_t::template make_state<colite::coroutine_state<R>>(colite::allocator::allocator<std::byte> {}))
+        {
+            base_promise_t::record_origin(*state_, location);
+        }
+
+        // 参数包之后无法再添加默认参数，以分配器参数开头的协程不记录创建位置
+        template<typename Alloc, typename... Args>
+        promise_type(std::allocator_arg_t, const Alloc& alloc, const Args&...):
+            state_(base_promise_t::template make_state<colite::coroutine_state<R>>(base_promise_t::rebind_allocator(alloc)))
+        {
+            base_promise_t::record_origin(*state_, std::source_location {});
+        }
+
+        template<typename This, typename Alloc, typename... Args>
+        promise_type(const This&, std::allocator_arg_t, const Alloc& alloc, const Args&...):
+            state_(base_promise_t::template make_state<colite::coroutine_state<R>>(base_promise_t::rebind_allocator(alloc)))
+        {
+            base_promise_t::record_origin(*state_, std::source_location {});
+        }
+
         std::suspend_never final_suspend() noexcept {
-            colite_assert(state_->get_status() != coroutine_status::CANCELED);
-            state_->set_status(coroutine_status::FINISHED);
+            // 运行期间的取消请求被推迟到挂起点，因此这里不可能处于 CANCELED 状态
+            [[maybe_unused]] auto finished = state_->transition(coroutine_status::RUNNING, coroutine_status::FINISHED);
+            colite_assert(finished);
+            // 完成任务的条件已成立，通知其所在的调度器
+            if (auto dispatcher = state_->get_dispatcher()) {
+                dispatcher->coroutine_finished();
+            }
             return {};
         }
 
         auto get_return_object() -> Coro {
             this_handle_ = std::coroutine_handle<promise_type>::from_promise(*this);
-            state_ = std::allocate_shared<colite::coroutine_state<R>, colite::allocator::allocator<std::byte>>({});
+            state_->handle_ = this_handle_;
             return Coro { this_handle_, state_ };
         }
 
         template<typename Any>
         auto await_transform(Any&& any) -> decltype(auto) {
+#ifdef COLITE_NO_EXCEPTIONS
+            // 取消令牌已被请求取消时，协程在这次 co_await 处挂起之后被销毁，被等待的子协程不再启动
+            auto canceled = state_->is_cancellation_requested();
+            return colite::detail::cancel_point<decltype(transform(std::forward<Any>(any), false))> {
+                canceled ? state_.get() : nullptr,
+                transform(std::forward<Any>(any), !canceled)
+            };
+#else
+            // 取消令牌已被请求取消时，在 co_await 处抛出
+            if (state_->is_cancellation_requested()) {
+                throw colite::operation_canceled {};
+            }
+            return transform(std::forward<Any>(any), true);
+#endif
+        }
+
+        /**
+         * @brief 将 co_await 的操作数转换为可等待对象
+         * @param any 操作数
+         * @param start 是否启动尚未启动的子协程
+         */
+        template<typename Any>
+        auto transform(Any&& any, bool start) -> decltype(auto) {
             if constexpr (colite::traits::is_std_chrono_duration<std::remove_cvref_t<Any>>) {
-                return state_->get_dispatcher()->sleep(std::forward<Any>(any));
+                return colite::detail::sleep_awaiter { std::forward<Any>(any) };
             } else if constexpr (colite::traits::is_suspend<std::remove_cvref_t<Any>>) {
-                if (any && any.state_->get_status() == coroutine_status::CREATED) {
-                    return state_->get_dispatcher()->launch(std::forward<Any>(any));
+                if (start && any && any.state_->get_status() == coroutine_status::CREATED) {
+                    // 被等待的子协程继承当前协程的优先级与取消令牌
+                    if (!any.state_->get_cancellation()) {
+                        any.state_->set_cancellation(state_->get_cancellation());
+                    }
+                    return state_->get_dispatcher()->launch_internal(std::forward<Any>(any), state_->get_priority());
                 } else {
                     return std::forward<Any>(any);
                 }
@@ -65,16 +314,36 @@ namespace colite::detail {
             }
         }
 
-        void return_value(R&& ret) {
+        // 返回值直接在等待者提供的存储中构造，不经过中间的临时对象
+        template<typename U = R>
+            requires (!std::is_reference_v<R> && std::is_constructible_v<R, U&&>)
+        void return_value(U&& ret) {
+            state_->emplace_return_value(std::forward<U>(ret));
+        }
+
+        void return_value(R&& ret) requires std::is_reference_v<R> {
             state_->set_return_value(std::move(ret));
         }
 
-        void return_value(const R& ret) {
+        void return_value(const R& ret) requires std::is_reference_v<R> {
             state_->set_return_value(ret);
         }
 
         void unhandled_exception() {
+#ifdef COLITE_NO_EXCEPTIONS
+            std::abort();
+#else
             state_->exception_ptr_ = std::current_exception();
+#endif
+        }
+
+        /**
+         * @brief 获取当前协程的状态，供自定义的等待体使用
+         * @return
+         */
+        [[nodiscard]]
+        auto get_state() const -> const std::shared_ptr<colite::coroutine_state<R>>& {
+            return state_;
         }
 
     protected:
@@ -98,25 +367,79 @@ namespace colite::detail {
         using base_promise_t::operator new;
         using base_promise_t::operator delete;
 
+        // 默认参数在协程函数中求值，记录的是协程函数的位置
+        explicit promise_type(const std::source_location& location = std::source_location::current()):
+            state_(base_promise_t::template make_state<colite::coroutine_state<>>(colite::allocator::allocator<std::byte> {}))
+        {
+            base_promise_t::record_origin(*state_, location);
+        }
+
+        // 参数包之后无法再添加默认参数，以分配器参数开头的协程不记录创建位置
+        template<typename Alloc, typename... Args>
+        promise_type(std::allocator_arg_t, const Alloc& alloc, const Args&...):
+            state_(base_promise_t::template make_state<colite::coroutine_state<>>(base_promise_t::rebind_allocator(alloc)))
+        {
+            base_promise_t::record_origin(*state_, std::source_location {});
+        }
+
+        template<typename This, typename Alloc, typename... Args>
+        promise_type(const This&, std::allocator_arg_t, const Alloc& alloc, const Args&...):
+            state_(base_promise_t::template make_state<colite::coroutine_state<>>(base_promise_t::rebind_allocator(alloc)))
+        {
+            base_promise_t::record_origin(*state_, std::source_location {});
+        }
+
         std::suspend_never final_suspend() noexcept {
-            colite_assert(state_->get_status() != coroutine_status::CANCELED);
-            state_->set_status(coroutine_status::FINISHED);
+            // 运行期间的取消请求被推迟到挂起点，因此这里不可能处于 CANCELED 状态
+            [[maybe_unused]] auto finished = state_->transition(coroutine_status::RUNNING, coroutine_status::FINISHED);
+            colite_assert(finished);
+            // 完成任务的条件已成立，通知其所在的调度器
+            if (auto dispatcher = state_->get_dispatcher()) {
+                dispatcher->coroutine_finished();
+            }
             return {};
         }
 
         auto get_return_object() -> Coro {
             this_handle_ = std::coroutine_handle<promise_type>::from_promise(*this);
-            state_ = std::allocate_shared<colite::coroutine_state<>, colite::allocator::allocator<std::byte>>({});
+            state_->handle_ = this_handle_;
             return Coro { this_handle_, state_ };
         }
 
         template<typename Any>
         auto await_transform(Any&& any) -> decltype(auto) {
+#ifdef COLITE_NO_EXCEPTIONS
+            // 取消令牌已被请求取消时，协程在这次 co_await 处挂起之后被销毁，被等待的子协程不再启动
+            auto canceled = state_->is_cancellation_requested();
+            return colite::detail::cancel_point<decltype(transform(std::forward<Any>(any), false))> {
+                canceled ? state_.get() : nullptr,
+                transform(std::forward<Any>(any), !canceled)
+            };
+#else
+            // 取消令牌已被请求取消时，在 co_await 处抛出
+            if (state_->is_cancellation_requested()) {
+                throw colite::operation_canceled {};
+            }
+            return transform(std::forward<Any>(any), true);
+#endif
+        }
+
+        /**
+         * @brief 将 co_await 的操作数转换为可等待对象
+         * @param any 操作数
+         * @param start 是否启动尚未启动的子协程
+         */
+        template<typename Any>
+        auto transform(Any&& any, bool start) -> decltype(auto) {
             if constexpr (colite::traits::is_std_chrono_duration<std::remove_cvref_t<Any>>) {
-                return state_->dispatcher_->sleep(std::forward<Any>(any));
+                return colite::detail::sleep_awaiter { std::forward<Any>(any) };
             } else if constexpr (colite::traits::is_suspend<std::remove_cvref_t<Any>>) {
-                if (any && any.state_->status_ == coroutine_status::CREATED) {
-                    return state_->dispatcher_->launch(std::forward<Any>(any));
+                if (start && any && any.state_->get_status() == coroutine_status::CREATED) {
+                    // 被等待的子协程继承当前协程的优先级与取消令牌
+                    if (!any.state_->get_cancellation()) {
+                        any.state_->set_cancellation(state_->get_cancellation());
+                    }
+                    return state_->get_dispatcher()->launch_internal(std::forward<Any>(any), state_->get_priority());
                 } else {
                     return std::forward<Any>(any);
                 }
@@ -130,7 +453,20 @@ namespace colite::detail {
         }
 
         void unhandled_exception() {
+#ifdef COLITE_NO_EXCEPTIONS
+            std::abort();
+#else
             state_->exception_ptr_ = std::current_exception();
+#endif
+        }
+
+        /**
+         * @brief 获取当前协程的状态，供自定义的等待体使用
+         * @return
+         */
+        [[nodiscard]]
+        auto get_state() const -> const std::shared_ptr<colite::coroutine_state<>>& {
+            return state_;
         }
 
     protected:
@@ -148,9 +484,18 @@ namespace colite {
 
         friend class colite::dispatcher;
 
+        template<typename Derived>
+        friend class colite::basic_dispatcher;
+
         template<typename Coro, typename R>
         friend class colite::detail::promise_type;
 
+        template<typename R>
+        friend class colite::detail::timeout_awaiter;
+
+        template<typename R>
+        friend class colite::detail::propagate_awaiter;
+
         suspend() = default;
         suspend(const suspend&) = delete;
         suspend& operator=(const suspend&) = delete;
@@ -190,36 +535,57 @@ namespace colite {
         [[nodiscard]]
         auto await_ready() const -> bool {
             if (!*this) {
-                throw std::runtime_error("suspend<T> is null.");
+                colite_throw(std::runtime_error("suspend<T> is null."));
             }
             if (!state_->get_dispatcher()) {
-                throw std::runtime_error("suspend<T> is not associated with any dispatcher.");
+                colite_throw(std::runtime_error("suspend<T> is not associated with any dispatcher."));
             }
             if (state_->get_status() == coroutine_status::CANCELED) {
-                throw std::runtime_error("suspend<T> is being `co_await` when it was cancelled.");
+#ifdef COLITE_NO_EXCEPTIONS
+                // 由 await_suspend 取消等待者
+                return false;
+#else
+                throw colite::operation_canceled("suspend<T> is being `co_await` when it was cancelled.");
+#endif
             }
             if (state_->is_awaited()) {
-                throw std::runtime_error("suspend<T> is being `co_await` twice or it was cancelled.");
+                colite_throw(std::runtime_error("suspend<T> is being `co_await` twice or it was cancelled."));
             }
-            return this_handle_.done();
+            return state_->get_status() == coroutine_status::FINISHED;
         }
 
         template<typename Promise>
-        void await_suspend(std::coroutine_handle<Promise> ext_handle) {
+        auto await_suspend(std::coroutine_handle<Promise> ext_handle) -> bool {
             colite_assert(*this);
+#ifndef COLITE_NO_EXCEPTIONS
             if (state_->get_status() == coroutine_status::CANCELED) {
-                throw std::runtime_error("suspend<T> is being `co_await` when it was cancelled.");
+                throw colite::operation_canceled("suspend<T> is being `co_await` when it was cancelled.");
+            }
+#endif
+            std::shared_ptr<base_coroutine_state> awaiter_state = ext_handle.promise().get_state();
+            auto state = state_;
+#ifdef COLITE_NO_EXCEPTIONS
+            // 没有异常时，该协程被取消则等待者随之被取消，而不是在 co_await 处观察到取消
+            state->set_completion(&colite::detail::cancel_with_child);
+#endif
+            // 挂起之后当前对象（位于等待者的协程帧中）可能随时被销毁，之后只使用局部变量
+            awaiter_state->suspended("child", state->get_handle().address());
+            if (state->await(awaiter_state)) {
+                return true;
             }
-            auto dispatcher = ext_handle.promise().state_->get_dispatcher();
-            state_->await(ext_handle, dispatcher);
+#ifdef COLITE_NO_EXCEPTIONS
+            if (state->get_status() == coroutine_status::CANCELED) {
+                colite::dispatcher::request_cancel(*awaiter_state);
+                return true;
+            }
+#endif
+            // 该协程在登记等待者之前就已经结束，不再挂起；若等待者在此期间被取消，则保持挂起由取消者销毁
+            return !awaiter_state->try_resume();
         }
 
+        // 返回值直接从协程状态中移出，只移动一次
         auto await_resume() -> T {
-            colite_assert(*this);
-            if (state_->get_status() == colite::coroutine_status::CANCELED) {
-                throw std::runtime_error("suspend<T> has been canceled.");
-            }
-            check_and_throw_exception();
+            check_resume();
             if constexpr (!std::is_same_v<T, void>) {
                 return state_->get_return_value();
             } else {
@@ -227,16 +593,42 @@ namespace colite {
             }
         }
 
+        /**
+         * @brief co_await 结束时的检查：协程被取消或以异常结束时抛出
+         */
+        void check_resume() {
+            colite_assert(*this);
+            if (state_->get_status() == colite::coroutine_status::CANCELED) {
+                colite_throw(colite::operation_canceled("suspend<T> has been canceled."));
+            }
+            check_and_throw_exception();
+        }
+
+        /**
+         * @brief 协程以异常结束时重新抛出该异常。只检查指针，没有异常时不复制 exception_ptr；COLITE_NO_EXCEPTIONS 下无操作
+         */
         void check_and_throw_exception() {
-            if (!*this) {
+#ifndef COLITE_NO_EXCEPTIONS
+            if (!*this || !state_->exception_ptr_) {
                 return;
             }
-            auto ex = state_->exception_ptr_;
-            if (ex) {
-                state_->exception_ptr_ = nullptr;
-                cancel();
-                std::rethrow_exception(ex);
-            }
+            auto ex = std::exchange(state_->exception_ptr_, nullptr);
+            cancel();
+            std::rethrow_exception(ex);
+#endif
+        }
+
+        /**
+         * @brief 为尚未启动的协程绑定取消令牌：`d.launch(handle(request).with_cancellation(source.token()));`
+         *        该协程等待的子协程自动继承该令牌
+         * @param token 取消令牌
+         * @return 当前对象
+         */
+        auto with_cancellation(const cancellation_token& token) && -> suspend&& {
+            colite_assert(*this);
+            colite_assert(state_->get_status() == coroutine_status::CREATED);
+            state_->set_cancellation(token.get_state());
+            return std::move(*this);
         }
 
         void detach() {
@@ -246,26 +638,18 @@ namespace colite {
         }
 
         /**
-         * @brief 取消协程，若协程已被取消或正常执行完毕，则无操作
+         * @brief 取消协程，若协程已被取消或正常执行完毕，则无操作；若协程正在运行，则取消推迟到其下一个挂起点
          */
         void cancel() {
             if (!*this) {
                 return;
             }
-            auto status = state_->get_status();
-            if (status == coroutine_status::FINISHED || status == coroutine_status::CANCELED) {
-                return;
-            }
-            state_->set_status(coroutine_status::CANCELED);
-            auto dispatcher = state_->get_dispatcher();
-            if (dispatcher) {
-                dispatcher->cancel(this_handle_);
-            }
-            this_handle_.destroy();
+            colite::dispatcher::request_cancel(*state_);
         }
     protected:
         std::coroutine_handle<promise_type> this_handle_ {};
         std::shared_ptr<colite::coroutine_state<T>> state_ {};
         bool has_detached_ = false;
+
     };
 }
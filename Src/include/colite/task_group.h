@@ -0,0 +1,427 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ranges>
+#include <type_traits>
+#include <vector>
+#include "colite/allocator.h"
+#include "colite/port.h"
+#include "colite/spin_lock.h"
+#include "colite/state.h"
+#include "colite/traits.h"
+#include "colite/dispatchers.h"
+#include "colite/suspend.h"
+
+namespace colite {
+    namespace detail {
+        // task_group 默认的返回值回调，丢弃子协程的返回值
+        struct discard_result {
+            template<typename... Args>
+            void operator()(Args&&...) const {  }
+        };
+
+        // parallel_transform 的返回值回调，将返回值写入对应的位置
+        template<typename R>
+        struct store_result {
+            void operator()(R&& value) const {
+                (*results_)[index_].emplace(std::move(value));
+            }
+
+            std::shared_ptr<std::vector<std::optional<R>>> results_;
+            size_t index_;
+        };
+    }
+
+    /**
+     * @brief 限制并发数量的子协程组。同一时刻最多有 max_in_flight 个子协程存活，达到上限时 spawn 会等待空位：
+     *        ```
+     *        colite::task_group group { dispatcher, 16 };
+     *        for (auto& item : items) { co_await group.spawn(process(item)); }
+     *        co_await group.join();
+     *        ```
+     *        spawn 与 join 只应由同一个协程调用
+     */
+    class task_group {
+        struct group_state;
+
+        class slot_lease;
+
+        template<typename T, typename Sink>
+        static auto run_child(
+            slot_lease lease,
+            colite::suspend<T> child,
+            Sink sink
+        ) -> colite::suspend<> {
+#ifndef COLITE_NO_EXCEPTIONS
+            try {
+#endif
+                if constexpr (std::is_void_v<T>) {
+                    co_await std::move(child);
+                    sink();
+                } else {
+                    sink(co_await std::move(child));
+                }
+#ifndef COLITE_NO_EXCEPTIONS
+            } catch (...) {
+                lease.get_group()->fail(std::current_exception());
+            }
+#endif
+            lease.release();
+        }
+
+        // 子协程槽位，generation 用于识别已被取消并复用的槽位
+        struct slot {
+            colite::suspend<> wrapper_ {};
+            uint64_t generation_ = 0;
+            bool active_ = false;
+        };
+
+        struct group_state {
+            group_state(size_t max_in_flight, bool cancel_on_failure):
+                max_in_flight_(max_in_flight),
+                cancel_on_failure_(cancel_on_failure)
+            {
+                slots_.resize(max_in_flight);
+            }
+
+            auto has_capacity() -> bool {
+                return active_ < max_in_flight_ || has_failed();
+            }
+
+            // 是否已有子协程以异常结束，没有异常时子协程不会失败，须持有锁
+            auto has_failed() const -> bool {
+#ifndef COLITE_NO_EXCEPTIONS
+                return first_exception_ != nullptr;
+#else
+                return false;
+#endif
+            }
+
+            auto is_idle() -> bool {
+                return active_ == 0;
+            }
+
+            /**
+             * @brief 子协程结束，释放其槽位并唤醒等待者
+             */
+            void finished(size_t index, uint64_t generation) {
+                std::shared_ptr<base_coroutine_state> waiter = nullptr;
+                {
+                    std::lock_guard locker { lock_ };
+                    auto& it = slots_[index];
+                    if (!it.active_ || it.generation_ != generation) {
+                        return;
+                    }
+                    it.active_ = false;
+                    active_--;
+                    waiter = take_waiter();
+                }
+                if (waiter) {
+                    dispatcher::schedule_resume(waiter);
+                }
+            }
+
+#ifndef COLITE_NO_EXCEPTIONS
+            /**
+             * @brief 记录子协程的异常，并按需取消其余子协程
+             */
+            void fail(std::exception_ptr exception) {
+                {
+                    std::lock_guard locker { lock_ };
+                    if (!first_exception_) {
+                        first_exception_ = std::move(exception);
+                    }
+                }
+                if (cancel_on_failure_) {
+                    cancel_all();
+                }
+            }
+#endif
+
+            /**
+             * @brief 取消所有存活的子协程，并唤醒等待者。槽位仍由各自的 slot_lease 释放：
+             *        正在运行的子协程的取消被推迟到其下一个挂起点，在此之前仍计入并发数量
+             */
+            void cancel_all() {
+                std::vector<colite::suspend<>> canceled {};
+                std::shared_ptr<base_coroutine_state> waiter = nullptr;
+                {
+                    std::lock_guard locker { lock_ };
+                    for (auto& it : slots_) {
+                        if (it.active_) {
+                            canceled.emplace_back(std::move(it.wrapper_));
+                        }
+                    }
+                    waiter = take_waiter();
+                }
+                // 在锁外析构，由 suspend 的析构完成取消；已挂起的包装协程随之被销毁，其 slot_lease 在此释放槽位
+                canceled.clear();
+                if (waiter) {
+                    dispatcher::schedule_resume(waiter);
+                }
+            }
+
+            // 等待者的条件成立时取出等待者，须持有锁
+            auto take_waiter() -> std::shared_ptr<base_coroutine_state> {
+                if (waiter_ && (this->*waiter_condition_)()) {
+                    return std::move(waiter_);
+                }
+                return nullptr;
+            }
+
+            colite::port::spin_lock lock_ {};
+            const size_t max_in_flight_;
+            const bool cancel_on_failure_;
+            size_t active_ = 0;
+            std::vector<slot> slots_ {};
+#ifndef COLITE_NO_EXCEPTIONS
+            std::exception_ptr first_exception_ {};
+#endif
+            std::shared_ptr<base_coroutine_state> waiter_ {};
+            bool (group_state::*waiter_condition_)() = nullptr;
+        };
+
+        // 子协程对槽位的占用，作为 run_child 的参数存放在其协程帧中：子协程结束时释放；
+        // 包装协程随被取消的子协程一起被销毁（COLITE_NO_EXCEPTIONS）或在启动之前被销毁时，由析构释放
+        class slot_lease {
+        public:
+            slot_lease(std::shared_ptr<group_state> group, size_t index, uint64_t generation):
+                group_(std::move(group)),
+                index_(index),
+                generation_(generation)
+            {
+            }
+
+            slot_lease(slot_lease&& other) noexcept:
+                group_(std::move(other.group_)),
+                index_(other.index_),
+                generation_(other.generation_)
+            {
+            }
+
+            slot_lease(const slot_lease&) = delete;
+            slot_lease& operator=(const slot_lease&) = delete;
+            slot_lease& operator=(slot_lease&&) = delete;
+
+            ~slot_lease() {
+                release();
+            }
+
+            [[nodiscard]]
+            auto get_group() const -> const std::shared_ptr<group_state>& {
+                return group_;
+            }
+
+            void release() {
+                if (auto group = std::move(group_)) {
+                    group->finished(index_, generation_);
+                }
+            }
+
+        private:
+            std::shared_ptr<group_state> group_;
+            size_t index_;
+            uint64_t generation_;
+        };
+
+        // 等待条件成立：有空位（spawn）或全部结束（join）
+        template<bool (group_state::*Condition)()>
+        class wait_awaiter {
+        public:
+            explicit wait_awaiter(std::shared_ptr<group_state> group): group_(std::move(group)) {  }
+
+            [[nodiscard]]
+            auto await_ready() const -> bool {
+                std::lock_guard locker { group_->lock_ };
+                return ((*group_).*Condition)();
+            }
+
+            template<typename Promise>
+            auto await_suspend(std::coroutine_handle<Promise> handle) -> bool {
+                std::shared_ptr<base_coroutine_state> state = handle.promise().get_state();
+                auto group = group_;
+                std::lock_guard locker { group->lock_ };
+                if (((*group).*Condition)()) {
+                    return false;
+                }
+                colite_assert(!group->waiter_);
+                group->waiter_ = state;
+                group->waiter_condition_ = Condition;
+                // 挂起之后当前对象可能随协程帧一起被销毁，之后只使用局部变量
+                state->suspended("task_group", group.get());
+                return true;
+            }
+
+        protected:
+            std::shared_ptr<group_state> group_;
+        };
+
+    public:
+        template<typename T, typename Sink>
+        class spawn_awaiter: public wait_awaiter<&group_state::has_capacity> {
+        public:
+            spawn_awaiter(task_group& owner, colite::suspend<T>&& child, Sink sink):
+                wait_awaiter<&group_state::has_capacity>(owner.state_),
+                owner_(owner),
+                child_(std::move(child)),
+                sink_(std::move(sink))
+            {
+            }
+
+            void await_resume() {
+                owner_.start(std::move(child_), std::move(sink_));
+            }
+
+        private:
+            task_group& owner_;
+            colite::suspend<T> child_;
+            Sink sink_;
+        };
+
+        class join_awaiter: public wait_awaiter<&group_state::is_idle> {
+        public:
+            using wait_awaiter<&group_state::is_idle>::wait_awaiter;
+
+            void await_resume() {
+#ifndef COLITE_NO_EXCEPTIONS
+                std::lock_guard locker { this->group_->lock_ };
+                if (this->group_->first_exception_) {
+                    std::rethrow_exception(this->group_->first_exception_);
+                }
+#endif
+            }
+        };
+
+        /**
+         * @brief 创建子协程组
+         * @param dispatcher 子协程运行的调度器
+         * @param max_in_flight 同时存活的子协程数量上限
+         * @param cancel_on_failure 某个子协程失败时是否取消其余子协程
+         */
+        task_group(dispatcher& dispatcher, size_t max_in_flight, bool cancel_on_failure = true):
+            dispatcher_(dispatcher),
+            state_(std::allocate_shared<group_state, colite::allocator::allocator<std::byte>>({}, max_in_flight, cancel_on_failure))
+        {
+            colite_assert(max_in_flight > 0);
+        }
+
+        ~task_group() {
+            state_->cancel_all();
+        }
+
+        task_group(const task_group&) = delete;
+        task_group& operator=(const task_group&) = delete;
+
+        /**
+         * @brief 启动子协程，若已达到并发上限则先等待空位；若已有子协程失败，则抛出其异常
+         * @param child 子协程
+         * @param sink 接收子协程返回值的回调（可能在子协程的调度器线程上调用）
+         */
+        template<typename T, typename Sink = detail::discard_result>
+        auto spawn(colite::suspend<T>&& child, Sink sink = {}) -> spawn_awaiter<T, Sink> {
+            return spawn_awaiter<T, Sink>(*this, std::move(child), std::move(sink));
+        }
+
+        /**
+         * @brief 等待所有子协程结束，若有子协程失败则抛出第一个异常
+         */
+        auto join() -> join_awaiter {
+            return join_awaiter { state_ };
+        }
+
+        /**
+         * @brief 取消所有存活的子协程
+         */
+        void cancel() {
+            state_->cancel_all();
+        }
+
+    private:
+        dispatcher& dispatcher_;
+        std::shared_ptr<group_state> state_;
+
+        template<typename T, typename Sink>
+        void start(colite::suspend<T>&& child, Sink&& sink) {
+            std::lock_guard locker { state_->lock_ };
+#ifndef COLITE_NO_EXCEPTIONS
+            if (state_->first_exception_) {
+                std::rethrow_exception(state_->first_exception_);
+            }
+#endif
+            size_t index = 0;
+            while (state_->slots_[index].active_) {
+                index++;
+            }
+            auto& it = state_->slots_[index];
+            it.active_ = true;
+            it.generation_++;
+            state_->active_++;
+            it.wrapper_ = dispatcher_.launch_internal(run_child(slot_lease { state_, index, it.generation_ }, std::move(child), std::forward<Sink>(sink)));
+        }
+    };
+
+    /**
+     * @brief 对范围中的每个元素启动 fn(element) 返回的协程，同一时刻最多 max_in_flight 个
+     * @param dispatcher 子协程运行的调度器
+     * @param range 范围，须在返回的协程结束之前保持有效
+     * @param max_in_flight 并发上限
+     * @param fn 返回 colite::suspend<T> 的函数
+     * @param cancel_on_failure 某个子协程失败时是否取消其余子协程
+     */
+    template<typename Range, typename Fn>
+    auto parallel_for_each(
+        dispatcher& dispatcher,
+        Range&& range,
+        size_t max_in_flight,
+        Fn fn,
+        bool cancel_on_failure = true
+    ) -> colite::suspend<> {
+        task_group group { dispatcher, max_in_flight, cancel_on_failure };
+        for (auto&& element : range) {
+            co_await group.spawn(fn(element));
+        }
+        co_await group.join();
+    }
+
+    /**
+     * @brief 与 parallel_for_each 相同，并按范围中的顺序收集每个子协程的返回值
+     * @return 返回值列表
+     */
+    template<
+        typename Range,
+        typename Fn,
+        typename R = colite::traits::suspend_result_t<std::invoke_result_t<Fn&, std::ranges::range_reference_t<Range>>>
+    >
+    auto parallel_transform(
+        dispatcher& dispatcher,
+        Range&& range,
+        size_t max_in_flight,
+        Fn fn,
+        bool cancel_on_failure = true
+    ) -> colite::suspend<std::vector<R>> {
+        // 结果由子协程写入，子协程可能晚于当前协程结束（取消被推迟时），因此放在共享的内存中
+        auto results = std::allocate_shared<std::vector<std::optional<R>>, colite::allocator::allocator<std::byte>>({});
+        results->resize(static_cast<size_t>(std::ranges::distance(range)));
+        {
+            task_group group { dispatcher, max_in_flight, cancel_on_failure };
+            size_t index = 0;
+            for (auto&& element : range) {
+                // 先构造为局部变量再移入：部分编译器会重复析构 co_await 表达式中的聚合临时对象
+                detail::store_result<R> sink { results, index };
+                co_await group.spawn(fn(element), std::move(sink));
+                index++;
+            }
+            co_await group.join();
+        }
+        std::vector<R> values {};
+        values.reserve(results->size());
+        for (auto& it : *results) {
+            values.emplace_back(std::move(it).value());
+        }
+        co_return values;
+    }
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <coroutine>
+#include <memory>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include "colite/port.h"
+#include "colite/state.h"
+#include "colite/dispatchers.h"
+#include "colite/suspend.h"
+
+namespace colite {
+    namespace detail {
+        template<typename T>
+        class timeout_awaiter {
+            static_assert(!std::is_reference_v<T>, "colite::with_timeout does not support reference results.");
+        public:
+            using result_type = std::conditional_t<std::is_void_v<T>, bool, std::optional<T>>;
+
+            timeout_awaiter(colite::suspend<T>&& child, colite::port::time_duration timeout):
+                child_(std::move(child)),
+                timeout_(timeout)
+            {
+                colite_assert(child_);
+            }
+
+            [[nodiscard]]
+            auto await_ready() const -> bool {
+                return child_.state_->get_status() == coroutine_status::FINISHED;
+            }
+
+            template<typename Promise>
+            auto await_suspend(std::coroutine_handle<Promise> handle) -> bool {
+                std::shared_ptr<base_coroutine_state> state = handle.promise().get_state();
+                auto dispatcher = state->get_dispatcher();
+                if (child_.state_->get_status() == coroutine_status::CREATED) {
+                    if (!child_.state_->get_cancellation()) {
+                        child_.state_->set_cancellation(state->get_cancellation());
+                    }
+                    dispatcher->launch_internal(child_, state->get_priority());
+                }
+                std::shared_ptr<base_coroutine_state> child = child_.state_;
+                // 挂起之后当前对象可能随协程帧一起被销毁，之后只使用局部变量
+                state->suspended("timeout", child->get_handle().address());
+                // 先布置定时器再登记等待，子协程在登记之后随即结束时，交接函数作废的是已布置的定时器。
+                // 定时器属于库的内部任务，不经过容量限制；它持有子协程状态，以保证其作废标记在定时器析构之前有效
+                auto tombstone = child->get_timeout_tombstone();
+                dispatcher->dispatch_revocable(nullptr, timeout_, state->get_priority(), [child] {
+                    colite::dispatcher::request_cancel(*child);
+                }, tombstone);
+                child->set_completion(&disarm);
+                if (!child->await(state)) {
+                    // 子协程已结束或已被取消，定时器不再需要
+                    child->disarm_timeout();
+                    return !state->try_resume();
+                }
+                return true;
+            }
+
+            auto await_resume() -> result_type {
+                // 子协程被取消（超时）时返回空，正常结束时返回其结果或重新抛出其异常
+                if (child_.state_->get_status() != coroutine_status::FINISHED) {
+                    return result_type {};
+                }
+                child_.check_resume();
+                if constexpr (std::is_void_v<T>) {
+                    return true;
+                } else {
+                    // 直接从子协程状态中移出返回值，只移动一次
+                    return result_type { std::in_place, std::move(*child_.state_->peek_return_value()) };
+                }
+            }
+
+        private:
+            colite::suspend<T> child_;
+            colite::port::time_duration timeout_;
+
+            // 子协程结束或被取消之后的交接：作废尚未到期的定时器（O(1)，由调度器在扫描队列时丢弃），再恢复等待者
+            static void disarm(base_coroutine_state& child, const std::shared_ptr<base_coroutine_state>& awaiter) {
+                child.disarm_timeout();
+                colite::dispatcher::schedule_resume(awaiter);
+            }
+        };
+    }
+
+    /**
+     * @brief 为子协程设置超时：`auto r = co_await colite::with_timeout(fetch(), 100ms);`
+     *        到期时子协程被取消，其在调度器上的任务被删除；子协程先结束时定时器随即作废
+     * @param child 子协程，尚未启动时在当前协程的调度器上启动
+     * @param timeout 超时时间
+     * @return 等待体，`co_await` 的结果为 std::optional<T>，超时为空（T 为 void 时为 bool，超时为 false）
+     */
+    template<typename T>
+    auto with_timeout(colite::suspend<T>&& child, colite::port::time_duration timeout) -> detail::timeout_awaiter<T> {
+        return detail::timeout_awaiter<T>(std::move(child), timeout);
+    }
+}
@@ -60,6 +60,21 @@ namespace colite {
         template<typename T>
         constexpr bool is_suspend<colite::suspend<T>> = true;
 
+        /**
+         * @brief 获取协程 suspend 的返回值类型
+         * @tparam T
+         */
+        template<typename T>
+        struct suspend_result;
+
+        template<typename T>
+        struct suspend_result<colite::suspend<T>> {
+            using type = T;
+        };
+
+        template<typename T>
+        using suspend_result_t = typename suspend_result<T>::type;
+
         template<typename C>
         constexpr bool is_std_chrono_duration = false;
 
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <chrono>
+#include "colite/registry.h"
+#include "colite/state.h"
+
+colite::coroutine_registry::~coroutine_registry() {
+    // 仍存活的协程不再引用该注册表
+    std::lock_guard locker { lock_ };
+    while (head_) {
+        auto next = head_->registry_next_;
+        head_->registry_ = nullptr;
+        head_->registry_prev_ = nullptr;
+        head_->registry_next_ = nullptr;
+        head_ = next;
+    }
+}
+
+void colite::coroutine_registry::attach(base_coroutine_state *state) {
+    std::lock_guard locker { lock_ };
+    colite_assert(state->registry_ == nullptr);
+    state->registry_ = this;
+    state->registry_prev_ = nullptr;
+    state->registry_next_ = head_;
+    if (head_) {
+        head_->registry_prev_ = state;
+    }
+    head_ = state;
+    size_++;
+}
+
+void colite::coroutine_registry::detach(base_coroutine_state *state) {
+    std::lock_guard locker { lock_ };
+    if (state->registry_prev_) {
+        state->registry_prev_->registry_next_ = state->registry_next_;
+    } else {
+        head_ = state->registry_next_;
+    }
+    if (state->registry_next_) {
+        state->registry_next_->registry_prev_ = state->registry_prev_;
+    }
+    state->registry_ = nullptr;
+    state->registry_prev_ = nullptr;
+    state->registry_next_ = nullptr;
+    size_--;
+}
+
+auto colite::coroutine_registry::snapshot() -> std::vector<coroutine_info, colite::allocator::allocator<coroutine_info>> {
+    std::vector<coroutine_info, colite::allocator::allocator<coroutine_info>> infos {};
+    auto now = colite::port::current_time();
+    std::lock_guard locker { lock_ };
+    infos.reserve(size_);
+    for (auto it = head_; it; it = it->registry_next_) {
+        auto& info = infos.emplace_back(coroutine_info {
+            .id = it->handle_.address(),
+            .status = it->get_status(),
+            .priority = it->get_priority(),
+            .frame_size = it->frame_size_,
+            .location = it->location_,
+        });
+        if (info.status == coroutine_status::SUSPENDED) {
+            info.wait_reason = it->wait_reason_.load(std::memory_order_relaxed);
+            info.awaited = it->awaited_.load(std::memory_order_relaxed);
+            info.suspended_for = now - it->suspended_at_.load(std::memory_order_relaxed);
+        }
+    }
+    return infos;
+}
+
+auto colite::coroutine_registry::size() -> std::size_t {
+    std::lock_guard locker { lock_ };
+    return size_;
+}
+
+void colite::coroutine_registry::dump(std::FILE *out) {
+    static constexpr const char *status_names[] = { "CREATED", "STARTED", "RUNNING", "SUSPENDED", "FINISHED", "CANCELED" };
+    auto infos = snapshot();
+    std::sort(infos.begin(), infos.end(), [] (const coroutine_info& a, const coroutine_info& b) {
+        return a.suspended_for > b.suspended_for;
+    });
+    std::size_t frame_bytes = 0;
+    for (auto& info : infos) {
+        frame_bytes += info.frame_size;
+    }
+    fprintf(out, "-- colite: %zu live coroutines, %zu frame bytes\n", infos.size(), frame_bytes);
+    for (auto& info : infos) {
+        char wait[64] = "-";
+        if (info.wait_reason) {
+            snprintf(wait, sizeof(wait), "%s(%p)", info.wait_reason, info.awaited);
+        }
+        auto suspended_ms = std::chrono::duration_cast<std::chrono::milliseconds>(info.suspended_for).count();
+        fprintf(
+            out,
+            "%p %-9s priority=%d frame=%zu suspended=%lldms wait=%s at %s:%u %s\n",
+            info.id,
+            status_names[static_cast<std::size_t>(info.status)],
+            static_cast<int>(info.priority),
+            info.frame_size,
+            static_cast<long long>(suspended_ms),
+            wait,
+            info.location.file_name(),
+            static_cast<unsigned>(info.location.line()),
+            info.location.function_name()
+        );
+    }
+}
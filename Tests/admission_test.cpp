@@ -0,0 +1,174 @@
+// 容量限制与过载策略：BLOCK、REJECT（含 try_post、try_launch）、SHED_OLDEST、SHED_LOWEST
+#include <atomic>
+#include <thread>
+#include <vector>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    // 反复执行事件循环直到没有就绪的任务
+    void drain(colite::port::eventloop_dispatcher& loop) {
+        for (int i = 0; i < 100; i++) {
+            loop.poll();
+        }
+    }
+
+    // 普通任务向自身所在的、已满的调度器投递任务时不能阻塞事件循环线程
+    void block_from_own_job() {
+        colite::port::eventloop_dispatcher loop {};
+        loop.set_queue_limits({ .max_jobs = 1, .policy = colite::overload_policy::BLOCK });
+        int ran = 0;
+        loop.post([&] {
+            loop.post([&] { ran++; });
+            // 队列已满，且唯一能腾出空位的线程正是当前线程
+            loop.post([&] { ran++; });
+            ran++;
+        });
+        drain(loop);
+        COLITE_CHECK(ran == 3);
+        COLITE_CHECK(loop.pending_jobs(colite::priority::NORMAL) == 0);
+    }
+
+    // 其他线程在队列已满时被阻塞，直到事件循环腾出空位
+    void block_other_thread() {
+        colite::port::eventloop_dispatcher loop {};
+        loop.set_queue_limits({ .max_jobs = 2, .policy = colite::overload_policy::BLOCK });
+        std::atomic<int> ran = 0;
+        std::thread producer([&] {
+            for (int i = 0; i < 50; i++) {
+                loop.post([&] { ran++; });
+            }
+        });
+        std::thread worker([&] { loop.run_forever(); });
+        producer.join();
+        while (ran < 50) {
+            std::this_thread::sleep_for(1ms);
+        }
+        loop.stop();
+        worker.join();
+        COLITE_CHECK(ran == 50);
+        COLITE_CHECK(loop.get_queue_stats().blocked > 0);
+    }
+
+    auto job(int& ran) -> colite::suspend<> {
+        ran++;
+        co_return;
+    }
+
+    // 协程超出上限启动新任务时不阻塞线程，而是在有空位之后才被恢复
+    auto block_coroutine(colite::port::eventloop_dispatcher& loop, int& ran) -> colite::suspend<> {
+        loop.set_queue_limits({ .max_jobs = 2, .policy = colite::overload_policy::BLOCK });
+        std::vector<colite::suspend<>> jobs {};
+        for (int i = 0; i < 3; i++) {
+            jobs.push_back(loop.launch(job(ran)));
+        }
+        // 第三个任务超出上限：协程在这里暂停，直到有任务开始执行
+        co_await colite::yield();
+        COLITE_CHECK(loop.pending_jobs(colite::priority::NORMAL) < 2);
+        for (int i = 0; i < 3; i++) {
+            jobs.push_back(loop.launch(job(ran)));
+        }
+        for (auto& it : jobs) {
+            co_await std::move(it);
+        }
+        loop.set_queue_limits({});
+    }
+
+    void block_in_coroutine() {
+        colite::port::eventloop_dispatcher loop {};
+        int ran = 0;
+        loop.run(block_coroutine(loop, ran));
+        COLITE_CHECK(ran == 6);
+        COLITE_CHECK(loop.get_queue_stats().blocked > 0);
+    }
+
+#ifndef COLITE_NO_EXCEPTIONS
+    void reject() {
+        colite::port::eventloop_dispatcher loop {};
+        loop.set_queue_limits({ .max_jobs = 2, .policy = colite::overload_policy::REJECT });
+        int ran = 0;
+        int rejected = 0;
+        for (int i = 0; i < 5; i++) {
+            try {
+                loop.post([&] { ran++; });
+            } catch (const colite::queue_full&) {
+                rejected++;
+            }
+        }
+        drain(loop);
+        COLITE_CHECK(ran == 2);
+        COLITE_CHECK(rejected == 3);
+        COLITE_CHECK(loop.get_queue_stats().rejected == 3);
+    }
+#endif
+
+    // try_post 与 try_launch 以返回值报告拒绝，关闭异常时同样可用
+    void try_reject() {
+        colite::port::eventloop_dispatcher loop {};
+        loop.set_queue_limits({ .max_jobs = 2, .policy = colite::overload_policy::REJECT });
+        int ran = 0;
+        int rejected = 0;
+        for (int i = 0; i < 3; i++) {
+            auto result = loop.try_post([&] { ran++; });
+            if (!result) {
+                rejected += result.error() == colite::errc::queue_full;
+            }
+        }
+        auto launched = loop.try_launch(job(ran));
+        COLITE_CHECK(!launched);
+        COLITE_CHECK(launched.error() == colite::errc::queue_full);
+        drain(loop);
+        COLITE_CHECK(ran == 2);
+        COLITE_CHECK(rejected == 1);
+        // 有空位之后重新被接纳
+        launched = loop.try_launch(job(ran));
+        COLITE_CHECK(launched.has_value());
+        drain(loop);
+        COLITE_CHECK(ran == 3);
+        COLITE_CHECK(loop.get_queue_stats().rejected == 2);
+    }
+
+    void shed_oldest() {
+        colite::port::eventloop_dispatcher loop {};
+        loop.set_queue_limits({ .max_jobs = 2, .policy = colite::overload_policy::SHED_OLDEST });
+        std::vector<int> order {};
+        for (int i = 0; i < 4; i++) {
+            loop.post([&order, i] { order.push_back(i); });
+        }
+        drain(loop);
+        COLITE_CHECK((order == std::vector<int> { 2, 3 }));
+        COLITE_CHECK(loop.get_queue_stats().shed == 2);
+        COLITE_CHECK(loop.pending_jobs(colite::priority::NORMAL) == 0);
+    }
+
+    void shed_lowest() {
+        colite::port::eventloop_dispatcher loop {};
+        loop.set_queue_limits({ .max_jobs = 2, .policy = colite::overload_policy::SHED_LOWEST });
+        std::vector<int> order {};
+        loop.post([&] { order.push_back(100); }, colite::priority::BACKGROUND);
+        loop.post([&] { order.push_back(1); });
+        // 丢弃的是较低优先级的任务
+        loop.post([&] { order.push_back(2); });
+        // 没有不高于新任务优先级的任务可以丢弃时，丢弃新任务本身
+        loop.post([&] { order.push_back(101); }, colite::priority::BACKGROUND);
+        drain(loop);
+        COLITE_CHECK((order == std::vector<int> { 1, 2 }));
+        COLITE_CHECK(loop.get_queue_stats().shed == 2);
+    }
+}
+
+int main() {
+    block_from_own_job();
+    block_other_thread();
+    block_in_coroutine();
+#ifndef COLITE_NO_EXCEPTIONS
+    reject();
+#endif
+    try_reject();
+    shed_oldest();
+    shed_lowest();
+    return colite::test::result();
+}
@@ -0,0 +1,62 @@
+// colite::blocking 与 colite::try_blocking：结果传回原协程，线程池队列已满时的错误
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    auto compute(int& result) -> colite::suspend<> {
+        result = co_await colite::blocking([] { return 42; });
+    }
+
+    void returns_value() {
+        colite::port::eventloop_dispatcher loop {};
+        int result = 0;
+        loop.run(compute(result));
+        COLITE_CHECK(result == 42);
+    }
+
+    // 线程池只有一个线程且队列只容纳一个任务：占住线程与队列之后，try_blocking 返回 errc::blocking_pool_full
+    auto saturate(colite::blocking_pool& pool, std::atomic<bool>& release, int& full, int& value) -> colite::suspend<> {
+        pool.submit([&] {
+            while (!release) {
+                std::this_thread::sleep_for(1ms);
+            }
+        });
+        while (!pool.submit([] {})) {
+            std::this_thread::sleep_for(1ms);
+        }
+        auto rejected = co_await colite::try_blocking([] { return 1; }, pool);
+        if (!rejected) {
+            full += rejected.error() == colite::errc::blocking_pool_full;
+        }
+        release = true;
+        auto accepted = co_await colite::try_blocking([] { return 2; }, pool);
+        while (!accepted) {
+            std::this_thread::sleep_for(1ms);
+            accepted = co_await colite::try_blocking([] { return 2; }, pool);
+        }
+        value = *accepted;
+    }
+
+    void pool_full() {
+        colite::port::eventloop_dispatcher loop {};
+        colite::blocking_pool pool { { .max_threads = 1, .max_queue = 1 } };
+        std::atomic<bool> release = false;
+        int full = 0;
+        int value = 0;
+        loop.run(saturate(pool, release, full, value));
+        COLITE_CHECK(full == 1);
+        COLITE_CHECK(value == 2);
+    }
+}
+
+int main() {
+    returns_value();
+    pool_full();
+    return colite::test::result();
+}
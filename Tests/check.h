@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdio>
+
+namespace colite::test {
+    inline int failures = 0;
+
+    inline void report(bool passed, const char *expression, const char *file, int line) {
+        if (!passed) {
+            failures++;
+            std::fprintf(stderr, "%s:%d: check failed: %s\n", file, line, expression);
+        }
+    }
+
+    // 测试程序的返回值
+    inline auto result() -> int {
+        if (failures == 0) {
+            std::printf("all checks passed\n");
+        }
+        return failures == 0 ? 0 : 1;
+    }
+}
+
+// 检查失败时记录并继续，由 colite::test::result() 汇总
+#define COLITE_CHECK(expression) ::colite::test::report(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
@@ -0,0 +1,26 @@
+// TSC 时钟：显式校准之后与 steady_clock 同步流逝
+#include <chrono>
+#include <thread>
+#include "colite/port.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    void tracks_steady_clock() {
+        colite::port::calibrate_tsc_clock();
+        auto tsc_begin = colite::port::tsc_time();
+        auto steady_begin = std::chrono::steady_clock::now();
+        std::this_thread::sleep_for(50ms);
+        auto tsc_elapsed = colite::port::tsc_time() - tsc_begin;
+        auto steady_elapsed = std::chrono::steady_clock::now() - steady_begin;
+        auto error = tsc_elapsed > steady_elapsed ? tsc_elapsed - steady_elapsed : steady_elapsed - tsc_elapsed;
+        COLITE_CHECK(tsc_elapsed >= 40ms);
+        COLITE_CHECK(error < 5ms);
+    }
+}
+
+int main() {
+    tracks_steady_clock();
+    return colite::test::result();
+}
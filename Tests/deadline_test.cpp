@@ -0,0 +1,73 @@
+// eventloop_dispatcher::next_deadline：最早的就绪时间随任务入队与删除更新，等待子协程结束的任务在子协程结束时就绪
+#include <chrono>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    // 就绪时间距现在约为 expected
+    auto due_in(colite::port::time_point deadline, colite::port::time_duration expected) -> bool {
+        auto remaining = deadline - colite::port::current_time();
+        return remaining > expected - 1min && remaining <= expected;
+    }
+
+    auto sleeper(colite::port::time_duration delay) -> colite::suspend<> {
+        co_await delay;
+    }
+
+    void earliest_timer() {
+        colite::port::eventloop_dispatcher loop {};
+        colite::cancellation_source cancellation {};
+        loop.post([] {  }, 2h);
+        auto next = loop.poll();
+        COLITE_CHECK(due_in(next, 2h));
+        auto sleeping = loop.launch(sleeper(30min).with_cancellation(cancellation.token()));
+        for (int i = 0; i < 3; i++) {
+            next = loop.poll();
+        }
+        COLITE_CHECK(due_in(next, 30min));
+        // 最早的延迟任务被删除之后，下一个就绪时间退回到剩下的任务
+        cancellation.cancel();
+        for (int i = 0; i < 3; i++) {
+            next = loop.poll();
+        }
+        COLITE_CHECK(due_in(next, 2h));
+    }
+
+    auto child(int& steps) -> colite::suspend<int> {
+        for (int i = 0; i < 3; i++) {
+            steps++;
+            co_await colite::yield();
+        }
+        co_return 5;
+    }
+
+    auto parent(int& steps, int& value) -> colite::suspend<> {
+        value = co_await child(steps);
+    }
+
+    // 宿主循环按 next_deadline 等待：子协程结束之后完成任务已就绪，不会报告为没有可等待的任务
+    void completion_ready() {
+        colite::port::eventloop_dispatcher loop {};
+        int steps = 0;
+        int value = 0;
+        auto running = loop.launch(parent(steps, value));
+        for (int i = 0; i < 100 && value == 0; i++) {
+            auto next = loop.poll();
+            if (value == 0) {
+                COLITE_CHECK(next <= colite::port::current_time());
+            }
+        }
+        COLITE_CHECK(steps == 3);
+        COLITE_CHECK(value == 5);
+        COLITE_CHECK(loop.poll() == colite::port::time_point::max());
+    }
+}
+
+int main() {
+    earliest_timer();
+    completion_ready();
+    return colite::test::result();
+}
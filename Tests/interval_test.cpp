@@ -0,0 +1,53 @@
+// interval：按固定节奏恢复等待的协程，协程被取消时其节拍随之从调度器上删除
+#include <chrono>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    auto ticks(colite::port::time_duration period, int count, int& ticked) -> colite::suspend<> {
+        colite::interval ticker { period };
+        for (int i = 0; i < count; i++) {
+            co_await ticker;
+            ticked++;
+        }
+    }
+
+    void periodic() {
+        colite::port::eventloop_dispatcher loop {};
+        int ticked = 0;
+        auto start = colite::port::current_time();
+        loop.run(ticks(2ms, 5, ticked));
+        COLITE_CHECK(ticked == 5);
+        COLITE_CHECK(colite::port::current_time() - start >= 10ms);
+    }
+
+    auto wait_tick(colite::interval& ticker, int& ticked) -> colite::suspend<> {
+        co_await ticker;
+        ticked++;
+    }
+
+    // 等待一小时的节拍时被取消：即使 interval 不随协程帧销毁，调度器上也不再留有该节拍
+    void canceled_while_waiting() {
+        colite::port::eventloop_dispatcher loop {};
+        colite::cancellation_source cancellation {};
+        colite::interval ticker { 1h };
+        int ticked = 0;
+        auto waiting = loop.launch(wait_tick(ticker, ticked).with_cancellation(cancellation.token()));
+        for (int i = 0; i < 3; i++) {
+            loop.poll();
+        }
+        COLITE_CHECK(loop.poll() != colite::port::time_point::max());
+        cancellation.cancel();
+        COLITE_CHECK(loop.poll() == colite::port::time_point::max());
+        COLITE_CHECK(ticked == 0);
+    }
+}
+
+int main() {
+    periodic();
+    canceled_while_waiting();
+    return colite::test::result();
+}
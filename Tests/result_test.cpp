@@ -0,0 +1,121 @@
+// 返回值的交付：co_return 在协程状态中原地构造返回值，co_await、with_timeout 与 propagate 只从那里移出一次
+#include <chrono>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    // 记录移动与复制的次数
+    struct counted {
+        static inline int moves = 0;
+        static inline int copies = 0;
+
+        int value = 0;
+
+        explicit counted(int value): value(value) {  }
+        counted(counted&& other) noexcept: value(other.value) { moves++; }
+        counted(const counted& other): value(other.value) { copies++; }
+        counted& operator=(counted&&) = delete;
+        counted& operator=(const counted&) = delete;
+
+        static void reset() {
+            moves = 0;
+            copies = 0;
+        }
+    };
+
+    // 由构造参数原地构造，不产生中间对象
+    auto make(int value) -> colite::suspend<counted> {
+        co_await colite::yield();
+        co_return value;
+    }
+
+    // 返回局部变量：隐式移动进协程状态
+    auto make_local(int value) -> colite::suspend<counted> {
+        counted result { value };
+        co_await colite::yield();
+        co_return result;
+    }
+
+    auto make_expected(int value) -> colite::suspend<colite::expected<counted, int>> {
+        co_await colite::yield();
+        co_return value;
+    }
+
+    auto await_direct(int& moves, int& value) -> colite::suspend<> {
+        counted::reset();
+        counted result = co_await make(7);
+        moves = counted::moves;
+        value = result.value;
+    }
+
+    auto await_local(int& moves) -> colite::suspend<> {
+        counted::reset();
+        counted result = co_await make_local(7);
+        moves = counted::moves;
+    }
+
+    auto await_timeout(int& moves, int& value) -> colite::suspend<> {
+        counted::reset();
+        auto result = co_await colite::with_timeout(make(7), 1s);
+        moves = counted::moves;
+        value = result ? result->value : 0;
+    }
+
+    auto await_propagate(int& moves, int& value) -> colite::suspend<colite::expected<void, int>> {
+        counted::reset();
+        counted result = co_await colite::propagate(make_expected(7));
+        moves = counted::moves;
+        value = result.value;
+        co_return colite::expected<void, int> {};
+    }
+
+    void direct() {
+        colite::port::eventloop_dispatcher loop {};
+        int moves = -1;
+        int value = 0;
+        loop.run(await_direct(moves, value));
+        COLITE_CHECK(value == 7);
+        COLITE_CHECK(moves == 1);
+        COLITE_CHECK(counted::copies == 0);
+    }
+
+    void local() {
+        colite::port::eventloop_dispatcher loop {};
+        int moves = -1;
+        loop.run(await_local(moves));
+        // 移入协程状态一次，移出一次
+        COLITE_CHECK(moves == 2);
+        COLITE_CHECK(counted::copies == 0);
+    }
+
+    void timeout() {
+        colite::port::eventloop_dispatcher loop {};
+        int moves = -1;
+        int value = 0;
+        loop.run(await_timeout(moves, value));
+        COLITE_CHECK(value == 7);
+        COLITE_CHECK(moves == 1);
+        COLITE_CHECK(counted::copies == 0);
+    }
+
+    void propagate() {
+        colite::port::eventloop_dispatcher loop {};
+        int moves = -1;
+        int value = 0;
+        loop.run(await_propagate(moves, value));
+        COLITE_CHECK(value == 7);
+        COLITE_CHECK(moves == 1);
+        COLITE_CHECK(counted::copies == 0);
+    }
+}
+
+int main() {
+    direct();
+    local();
+    timeout();
+    propagate();
+    return colite::test::result();
+}
@@ -0,0 +1,137 @@
+// shared_suspend：多个等待者共享一次执行，原协程被取消时每个等待者都能结束
+#include <chrono>
+#include <thread>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    // 反复执行事件循环，直到条件成立或超时
+    template<typename Condition>
+    void run_until(colite::port::eventloop_dispatcher& loop, Condition&& condition) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            loop.poll();
+            std::this_thread::yield();
+        }
+    }
+
+    // 记录等待者的协程帧被销毁
+    struct frame_probe {
+        int& destroyed;
+        ~frame_probe() { destroyed++; }
+    };
+
+    auto source(int& runs) -> colite::suspend<int> {
+        runs++;
+        co_await colite::yield();
+        co_return 42;
+    }
+
+    auto waiter(colite::shared_suspend<int> shared, int& sum, int& resumed, int& destroyed) -> colite::suspend<> {
+        frame_probe probe { destroyed };
+        const int& value = co_await shared;
+        sum += value;
+        resumed++;
+    }
+
+    void multiple_waiters() {
+        colite::port::eventloop_dispatcher loop {};
+        int runs = 0;
+        int sum = 0;
+        int resumed = 0;
+        int destroyed = 0;
+        colite::shared_suspend<int> shared { source(runs) };
+        auto a = loop.launch(waiter(shared, sum, resumed, destroyed));
+        auto b = loop.launch(waiter(shared, sum, resumed, destroyed));
+        auto c = loop.launch(waiter(shared, sum, resumed, destroyed));
+        run_until(loop, [&] { return destroyed == 3; });
+        COLITE_CHECK(runs == 1);
+        COLITE_CHECK(resumed == 3);
+        COLITE_CHECK(sum == 3 * 42);
+        COLITE_CHECK(shared.is_ready());
+        // 完成之后的等待者不再挂起
+        auto late = loop.launch(waiter(shared, sum, resumed, destroyed));
+        run_until(loop, [&] { return destroyed == 4; });
+        COLITE_CHECK(resumed == 4);
+    }
+
+    // 等待者之一在完成之前被取消：其节点随协程帧一起注销，其余等待者照常得到结果
+    void waiter_canceled() {
+        colite::port::eventloop_dispatcher loop {};
+        colite::cancellation_source cancellation {};
+        int runs = 0;
+        int sum = 0;
+        int resumed = 0;
+        int destroyed = 0;
+        colite::shared_suspend<int> shared { source(runs) };
+        auto a = loop.launch(waiter(shared, sum, resumed, destroyed));
+        auto b = loop.launch(waiter(shared, sum, resumed, destroyed).with_cancellation(cancellation.token()));
+        auto c = loop.launch(waiter(shared, sum, resumed, destroyed));
+        // 三个等待者都已挂起，原协程停在 yield 处
+        loop.poll_one();
+        loop.poll_one();
+        loop.poll_one();
+        cancellation.cancel();
+        COLITE_CHECK(destroyed == 1);
+        run_until(loop, [&] { return destroyed == 3; });
+        COLITE_CHECK(runs == 1);
+        COLITE_CHECK(resumed == 2);
+        COLITE_CHECK(sum == 2 * 42);
+    }
+
+    auto endless() -> colite::suspend<int> {
+        co_await std::chrono::hours(1);
+        co_return 0;
+    }
+
+#ifndef COLITE_NO_EXCEPTIONS
+    auto catching_waiter(colite::shared_suspend<int> shared, int& canceled, int& destroyed) -> colite::suspend<> {
+        frame_probe probe { destroyed };
+        try {
+            co_await shared;
+        } catch (const colite::operation_canceled&) {
+            canceled++;
+        }
+    }
+#endif
+
+    // 原协程被取消：有异常时每个等待者在 co_await 处观察到取消，没有异常时等待者随之被取消
+    void source_canceled() {
+        colite::port::eventloop_dispatcher loop {};
+        colite::cancellation_source cancellation {};
+        colite::shared_suspend<int> shared { endless().with_cancellation(cancellation.token()) };
+        int destroyed = 0;
+#ifndef COLITE_NO_EXCEPTIONS
+        int canceled = 0;
+        auto a = loop.launch(catching_waiter(shared, canceled, destroyed));
+        auto b = loop.launch(catching_waiter(shared, canceled, destroyed));
+#else
+        int sum = 0;
+        int resumed = 0;
+        auto a = loop.launch(waiter(shared, sum, resumed, destroyed));
+        auto b = loop.launch(waiter(shared, sum, resumed, destroyed));
+#endif
+        for (int i = 0; i < 10; i++) {
+            loop.poll();
+        }
+        COLITE_CHECK(destroyed == 0);
+        cancellation.cancel();
+        run_until(loop, [&] { return destroyed == 2; });
+        COLITE_CHECK(destroyed == 2);
+#ifndef COLITE_NO_EXCEPTIONS
+        COLITE_CHECK(canceled == 2);
+#else
+        COLITE_CHECK(resumed == 0);
+#endif
+    }
+}
+
+int main() {
+    multiple_waiters();
+    waiter_canceled();
+    source_canceled();
+    return colite::test::result();
+}
@@ -0,0 +1,77 @@
+// simulation_dispatcher：虚拟时钟属于调度器本身，不影响 colite::port::current_time()；相同的种子复现相同的调度
+#include <chrono>
+#include <string>
+#include "colite/colite.h"
+#include "colite/simulation_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    auto worker(std::string& trace, char name, int count) -> colite::suspend<> {
+        for (int i = 0; i < count; i++) {
+            trace += name;
+            co_await 1s;
+        }
+    }
+
+    auto workers(std::string& trace) -> colite::suspend<> {
+        auto a = worker(trace, 'a', 3);
+        auto b = worker(trace, 'b', 3);
+        auto c = worker(trace, 'c', 3);
+        co_await std::move(a);
+        co_await std::move(b);
+        co_await std::move(c);
+    }
+
+    auto run_with_seed(uint64_t seed) -> std::string {
+        std::string trace {};
+        colite::simulation_dispatcher simulation { seed };
+        simulation.run(workers(trace));
+        return trace;
+    }
+
+    void reproducible() {
+        auto first = run_with_seed(7);
+        COLITE_CHECK(first.size() == 9);
+        COLITE_CHECK(run_with_seed(7) == first);
+    }
+
+    // 节拍以虚拟时钟计算：一小时的节拍几乎不花费真实时间
+    auto ticks(int count) -> colite::suspend<> {
+        colite::interval ticker { 1min };
+        for (int i = 0; i < count; i++) {
+            co_await ticker;
+        }
+    }
+
+    void virtual_interval() {
+        colite::simulation_dispatcher simulation {};
+        auto start = simulation.now();
+        auto real = std::chrono::steady_clock::now();
+        simulation.run(ticks(60));
+        COLITE_CHECK(simulation.now() - start == 60min);
+        COLITE_CHECK(std::chrono::steady_clock::now() - real < 10s);
+    }
+
+    // 进程的时钟不受虚拟时钟影响，两个仿真调度器各自计时
+    void independent_clocks() {
+        colite::simulation_dispatcher first {};
+        colite::simulation_dispatcher second {};
+        auto before = colite::port::current_time();
+        first.run_for(5h);
+        second.run_for(1h);
+        auto after = colite::port::current_time();
+        COLITE_CHECK(first.now() - second.now() == 4h);
+        COLITE_CHECK(after >= before);
+        COLITE_CHECK(after - before < 1h);
+        COLITE_CHECK(first.clock() == first.now());
+    }
+}
+
+int main() {
+    reproducible();
+    virtual_interval();
+    independent_clocks();
+    return colite::test::result();
+}
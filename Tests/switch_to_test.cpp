@@ -0,0 +1,58 @@
+// switch_to：协程迁移之后，其完成任务随之迁移到目标调度器上
+#include <chrono>
+#include <thread>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    // 反复执行事件循环，直到条件成立或超时
+    template<typename Condition>
+    void run_until(colite::port::eventloop_dispatcher& loop, Condition&& condition) {
+        auto deadline = std::chrono::steady_clock::now() + 5s;
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            loop.poll();
+            std::this_thread::yield();
+        }
+    }
+
+    auto migrated(colite::port::eventloop_dispatcher& target, bool suspend_first) -> colite::suspend<int> {
+        if (suspend_first) {
+            co_await colite::yield();
+        }
+        co_await colite::switch_to(target);
+        co_await colite::yield();
+        co_return 7;
+    }
+
+    auto wait_for(colite::suspend<int> child, int& value) -> colite::suspend<> {
+        value = co_await std::move(child);
+    }
+
+    // 协程迁移之后原调度器被销毁：完成任务已在目标调度器上，等待者仍能被恢复
+    void source_destroyed(bool suspend_first) {
+        colite::port::eventloop_dispatcher target {};
+        colite::suspend<int> child {};
+        {
+            colite::port::eventloop_dispatcher source {};
+            child = source.launch(migrated(target, suspend_first));
+            for (int i = 0; i < 10; i++) {
+                source.poll();
+            }
+        }
+        int value = 0;
+        auto waiter = target.launch(wait_for(std::move(child), value));
+        run_until(target, [&] { return value != 0; });
+        COLITE_CHECK(value == 7);
+    }
+}
+
+int main() {
+    // 在首次恢复期间迁移
+    source_destroyed(false);
+    // 在之后的恢复中迁移，已登记在原调度器上的完成任务被移走
+    source_destroyed(true);
+    return colite::test::result();
+}
@@ -0,0 +1,193 @@
+// task_group：并发上限、子协程失败与取消
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    auto work(int& running, int& peak, int& done) -> colite::suspend<> {
+        running++;
+        peak = std::max(peak, running);
+        co_await 1ms;
+        running--;
+        done++;
+    }
+
+    auto bounded(colite::port::eventloop_dispatcher& loop, int& peak, int& done) -> colite::suspend<> {
+        int running = 0;
+        colite::task_group group { loop, 3 };
+        for (int i = 0; i < 10; i++) {
+            co_await group.spawn(work(running, peak, done));
+        }
+        co_await group.join();
+    }
+
+    void max_in_flight() {
+        colite::port::eventloop_dispatcher loop {};
+        int peak = 0;
+        int done = 0;
+        loop.run(bounded(loop, peak, done));
+        COLITE_CHECK(done == 10);
+        COLITE_CHECK(peak == 3);
+    }
+
+    auto endless(int& finished) -> colite::suspend<> {
+        co_await std::chrono::hours(1);
+        finished++;
+    }
+
+    // 取消之后 join 立即返回，子协程不再运行
+    auto cancel_children(colite::port::eventloop_dispatcher& loop, int& finished) -> colite::suspend<> {
+        colite::task_group group { loop, 4 };
+        for (int i = 0; i < 4; i++) {
+            co_await group.spawn(endless(finished));
+        }
+        co_await colite::yield();
+        group.cancel();
+        co_await group.join();
+    }
+
+    void cancel() {
+        colite::port::eventloop_dispatcher loop {};
+        int finished = 0;
+        loop.run(cancel_children(loop, finished));
+        COLITE_CHECK(finished == 0);
+    }
+
+    auto value() -> colite::suspend<int> {
+        co_return 1;
+    }
+
+    struct signals {
+        std::atomic<bool> started = false;
+        std::atomic<bool> release = false;
+        std::atomic<bool> left = false;
+    };
+
+    // 接收返回值的回调在另一个事件循环上运行，直到 release 被设置才返回，期间包装协程处于运行状态
+    struct busy_sink {
+        void operator()(int) const {
+            signals_->started = true;
+            while (!signals_->release) {
+                std::this_thread::yield();
+            }
+            signals_->left = true;
+        }
+
+        signals *signals_;
+    };
+
+    auto release_later(signals& state) -> colite::suspend<> {
+        co_await 5ms;
+        state.release = true;
+    }
+
+    // 包装协程正在运行时被取消：取消推迟到其下一个挂起点，在此之前仍占用槽位，join 等待其结束
+    auto cancel_running(
+        colite::port::eventloop_dispatcher& loop,
+        colite::port::eventloop_dispatcher& worker,
+        signals& state,
+        bool& left_before_join
+    ) -> colite::suspend<> {
+        colite::task_group group { worker, 1 };
+        busy_sink sink { &state };
+        co_await group.spawn(value(), std::move(sink));
+        while (!state.started) {
+            co_await 1ms;
+        }
+        group.cancel();
+        auto releasing = loop.launch(release_later(state));
+        co_await group.join();
+        left_before_join = state.left;
+        co_await std::move(releasing);
+    }
+
+    void cancel_while_running() {
+        colite::port::eventloop_dispatcher loop {};
+        colite::port::eventloop_dispatcher worker {};
+        std::thread worker_thread([&] { worker.run_forever(); });
+        signals state {};
+        bool left_before_join = false;
+        loop.run(cancel_running(loop, worker, state, left_before_join));
+        worker.stop();
+        worker_thread.join();
+        COLITE_CHECK(state.left);
+        COLITE_CHECK(left_before_join);
+    }
+
+    // 子协程经由取消令牌被取消：没有异常时其包装协程随之被销毁，仍须释放槽位使 join 返回
+    auto canceled_by_token(colite::port::eventloop_dispatcher& loop, int& finished, int& failed) -> colite::suspend<> {
+        colite::cancellation_source cancellation {};
+        colite::task_group group { loop, 2, false };
+        co_await group.spawn(endless(finished).with_cancellation(cancellation.token()));
+        co_await group.spawn(endless(finished).with_cancellation(cancellation.token()));
+        co_await colite::yield();
+        cancellation.cancel();
+#ifndef COLITE_NO_EXCEPTIONS
+        try {
+            co_await group.join();
+        } catch (const colite::operation_canceled&) {
+            failed++;
+        }
+#else
+        co_await group.join();
+#endif
+    }
+
+    void child_canceled() {
+        colite::port::eventloop_dispatcher loop {};
+        int finished = 0;
+        int failed = 0;
+        loop.run(canceled_by_token(loop, finished, failed));
+        COLITE_CHECK(finished == 0);
+#ifndef COLITE_NO_EXCEPTIONS
+        COLITE_CHECK(failed == 1);
+#endif
+    }
+
+#ifndef COLITE_NO_EXCEPTIONS
+    auto failing() -> colite::suspend<> {
+        co_await colite::yield();
+        throw std::runtime_error("child failed");
+    }
+
+    // 子协程失败时取消其余子协程，join 抛出第一个异常
+    auto fail_fast(colite::port::eventloop_dispatcher& loop, int& finished, int& caught) -> colite::suspend<> {
+        colite::task_group group { loop, 4 };
+        co_await group.spawn(endless(finished));
+        co_await group.spawn(failing());
+        co_await group.spawn(endless(finished));
+        try {
+            co_await group.join();
+        } catch (const std::runtime_error& e) {
+            caught += std::string(e.what()) == "child failed";
+        }
+    }
+
+    void failure() {
+        colite::port::eventloop_dispatcher loop {};
+        int finished = 0;
+        int caught = 0;
+        loop.run(fail_fast(loop, finished, caught));
+        COLITE_CHECK(caught == 1);
+        COLITE_CHECK(finished == 0);
+    }
+#endif
+}
+
+int main() {
+    max_in_flight();
+    cancel();
+    cancel_while_running();
+    child_canceled();
+#ifndef COLITE_NO_EXCEPTIONS
+    failure();
+#endif
+    return colite::test::result();
+}
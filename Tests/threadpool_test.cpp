@@ -0,0 +1,59 @@
+// threadpool_dispatcher：大量任务复用工作项执行，任务捕获的对象在执行之后析构
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include "colite/colite.h"
+#include "colite/threadpool_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    // 等待条件成立或超时
+    template<typename Condition>
+    void wait_until(Condition&& condition) {
+        auto deadline = std::chrono::steady_clock::now() + 10s;
+        while (!condition() && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(1ms);
+        }
+    }
+
+    void many_jobs() {
+        colite::port::threadpool_dispatcher pool { 2, 4 };
+        std::atomic<int> ran = 0;
+        auto captured = std::make_shared<int>(0);
+        for (int i = 0; i < 2000; i++) {
+            auto priority = static_cast<colite::priority>(i % colite::priority_count);
+            pool.post([&ran, captured] { ran++; }, priority);
+        }
+        wait_until([&] { return ran == 2000; });
+        COLITE_CHECK(ran == 2000);
+        // 执行之后任务连同其捕获的对象一起析构，不随工作项保留到下一次使用
+        wait_until([&] { return captured.use_count() == 1; });
+        COLITE_CHECK(captured.use_count() == 1);
+    }
+
+    auto hops(std::atomic<int>& done) -> colite::suspend<> {
+        for (int i = 0; i < 10; i++) {
+            co_await colite::yield();
+        }
+        done++;
+    }
+
+    void coroutines() {
+        colite::port::threadpool_dispatcher pool { 2, 4 };
+        std::atomic<int> done = 0;
+        for (int i = 0; i < 100; i++) {
+            pool.launch(hops(done)).detach();
+        }
+        wait_until([&] { return done == 100; });
+        COLITE_CHECK(done == 100);
+    }
+}
+
+int main() {
+    many_jobs();
+    coroutines();
+    return colite::test::result();
+}
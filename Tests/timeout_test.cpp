@@ -0,0 +1,76 @@
+// with_timeout：到期取消子协程；子协程先结束时定时器作废，不再让事件循环等到其到期，也不推进仿真时钟
+#include <chrono>
+#include "colite/colite.h"
+#include "colite/eventloop_dispatcher.h"
+#include "colite/simulation_dispatcher.h"
+#include "check.h"
+
+using namespace std::chrono_literals;
+
+namespace {
+    auto quick(int value) -> colite::suspend<int> {
+        co_await colite::yield();
+        co_return value;
+    }
+
+    auto endless() -> colite::suspend<int> {
+        co_await std::chrono::hours(1);
+        co_return 0;
+    }
+
+    auto await_many(int& sum) -> colite::suspend<> {
+        for (int i = 0; i < 1000; i++) {
+            auto result = co_await colite::with_timeout(quick(1), std::chrono::hours(1));
+            sum += result.value_or(0);
+        }
+    }
+
+    // 一小时的定时器全部作废：run 在子协程结束之后即返回
+    void disarm() {
+        colite::port::eventloop_dispatcher loop {};
+        int sum = 0;
+        auto start = std::chrono::steady_clock::now();
+        loop.run(await_many(sum));
+        COLITE_CHECK(sum == 1000);
+        COLITE_CHECK(std::chrono::steady_clock::now() - start < 10s);
+    }
+
+    auto await_endless(bool& timed_out) -> colite::suspend<> {
+        auto result = co_await colite::with_timeout(endless(), 10ms);
+        timed_out = !result.has_value();
+    }
+
+    void expire() {
+        colite::port::eventloop_dispatcher loop {};
+        bool timed_out = false;
+        loop.run(await_endless(timed_out));
+        COLITE_CHECK(timed_out);
+    }
+
+    // 作废的定时器不推进虚拟时钟
+    void disarm_in_simulation() {
+        colite::simulation_dispatcher simulation {};
+        auto start = simulation.now();
+        int sum = 0;
+        simulation.run(await_many(sum));
+        COLITE_CHECK(sum == 1000);
+        COLITE_CHECK(simulation.now() == start);
+    }
+
+    void expire_in_simulation() {
+        colite::simulation_dispatcher simulation {};
+        auto start = simulation.now();
+        bool timed_out = false;
+        simulation.run(await_endless(timed_out));
+        COLITE_CHECK(timed_out);
+        COLITE_CHECK(simulation.now() - start == 10ms);
+    }
+}
+
+int main() {
+    disarm();
+    expire();
+    disarm_in_simulation();
+    expire_in_simulation();
+    return colite::test::result();
+}